@@ -0,0 +1,230 @@
+// Tsadik88@gmail.com
+#ifndef AVL_TREE_HPP
+#define AVL_TREE_HPP
+
+#include <deque>
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+#include "node.hpp"
+
+/**
+ * @class AvlTree
+ * @brief A self-balancing binary search tree built from Node objects.
+ *
+ * Every node has two child slots, where slot 0 is the left child and slot 1 is the
+ * right child, and empty slots hold nullptr as in Tree::insert. Heights are kept
+ * AVL-balanced, so the tree stays within 1.44 log2(n) levels on any insertion order,
+ * and search and insert are O(log n) in the worst case. Rotations relink nodes with
+ * Node::set_child, which keeps parent links and subtree sizes up to date.
+ *
+ * @tparam T The type of the values stored in the tree. It must define operator<.
+ */
+template <typename T>
+class AvlTree {
+public:
+    /**
+     * @brief Constructs an empty tree.
+     */
+    AvlTree() : root(nullptr) {}
+
+    AvlTree(const AvlTree&) = delete;
+    AvlTree& operator=(const AvlTree&) = delete;
+
+    /**
+     * @brief Gets the root node.
+     * @return The root node, or nullptr for an empty tree.
+     */
+    Node<T>* get_root() const { return root; }
+
+    /**
+     * @brief Gets the number of nodes.
+     * @return The number of nodes.
+     */
+    size_t size() const { return root ? root->get_subtree_size() : 0; }
+
+    /**
+     * @brief Gets the number of levels.
+     * @return The height of the tree, 0 for an empty tree.
+     */
+    int height() const { return height_of(root); }
+
+    /**
+     * @brief Inserts a value and rebalances the path above it.
+     *
+     * Equal values go to the right, so duplicates keep their insertion order in in-order
+     * traversal. At most one single or double rotation is needed per insert.
+     *
+     * @param value The value to insert.
+     * @return The node holding the value, owned by the tree.
+     */
+    Node<T>& insert(const T& value) {
+        nodes.emplace_back(value);
+        avl_node* added = &nodes.back();
+        added->add_empty_slot(2);
+        added->add_empty_slot(2);
+        if (!root) {
+            root = added;
+            return *added;
+        }
+
+        avl_node* parent = root;
+        size_t slot = 0;
+        while (true) {
+            slot = value < parent->get_value() ? 0 : 1;
+            Node<T>* next = parent->get_children()[slot];
+            if (!next) {
+                break;
+            }
+            parent = static_cast<avl_node*>(next);
+        }
+        parent->set_child(slot, added);
+        retrace(parent);
+        return *added;
+    }
+
+    /**
+     * @brief Finds a node holding a value equivalent to the given one.
+     * @param value The value to search for.
+     * @return The node, or nullptr if no node holds the value.
+     */
+    Node<T>* find(const T& value) const {
+        Node<T>* current = root;
+        while (current) {
+            if (value < current->get_value()) {
+                current = current->get_children()[0];
+            } else if (current->get_value() < value) {
+                current = current->get_children()[1];
+            } else {
+                return current;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Finds the first node in in-order whose value is not less than the given one.
+     * @param value The value to search for.
+     * @return The node, or nullptr if every value is less.
+     */
+    Node<T>* lower_bound(const T& value) const {
+        Node<T>* result = nullptr;
+        Node<T>* current = root;
+        while (current) {
+            if (current->get_value() < value) {
+                current = current->get_children()[1];
+            } else {
+                result = current;
+                current = current->get_children()[0];
+            }
+        }
+        return result;
+    }
+
+    /**
+     * @brief Visits every value in ascending order.
+     * @param visitor Called with each value.
+     */
+    template <typename Visitor>
+    void for_each_in_order(Visitor visitor) const {
+        std::vector<Node<T>*> stack;
+        Node<T>* current = root;
+        while (current || !stack.empty()) {
+            while (current) {
+                stack.push_back(current);
+                current = current->get_children()[0];
+            }
+            current = stack.back();
+            stack.pop_back();
+            visitor(current->get_value());
+            current = current->get_children()[1];
+        }
+    }
+
+private:
+    /**
+     * @class avl_node
+     * @brief A Node that also records the height of its subtree.
+     */
+    class avl_node : public Node<T> {
+    public:
+        explicit avl_node(const T& val) : Node<T>(val), height(1) {}
+
+        int height; ///< Number of levels in the subtree rooted at this node.
+    };
+
+    avl_node* root; ///< The root node, nullptr for an empty tree.
+    std::deque<avl_node> nodes; ///< Storage for every node, with stable addresses.
+
+    /**
+     * @brief Gets the height of a possibly empty subtree.
+     */
+    static int height_of(Node<T>* node) { return node ? static_cast<avl_node*>(node)->height : 0; }
+
+    /**
+     * @brief Gets a child as an avl_node.
+     */
+    static avl_node* child(avl_node* node, size_t slot) { return static_cast<avl_node*>(node->get_children()[slot]); }
+
+    /**
+     * @brief Recomputes a node's height from its children.
+     */
+    static void update_height(avl_node* node) {
+        node->height = 1 + std::max(height_of(node->get_children()[0]), height_of(node->get_children()[1]));
+    }
+
+    /**
+     * @brief Walks up from the parent of a new leaf, fixing heights and rotating the first unbalanced node.
+     */
+    void retrace(avl_node* current) {
+        while (current) {
+            int balance = height_of(current->get_children()[1]) - height_of(current->get_children()[0]);
+            if (balance > 1 || balance < -1) {
+                rebalance(current, balance > 0 ? 1 : 0);
+                return; // The rotated subtree is back to its height before the insert
+            }
+            int previous = current->height;
+            update_height(current);
+            if (current->height == previous) {
+                return; // Ancestors are unaffected
+            }
+            current = static_cast<avl_node*>(current->get_parent());
+        }
+    }
+
+    /**
+     * @brief Restores balance at a node whose heavy side is the given slot.
+     */
+    void rebalance(avl_node* node, size_t heavy) {
+        avl_node* heavy_child = child(node, heavy);
+        if (height_of(heavy_child->get_children()[1 - heavy]) > height_of(heavy_child->get_children()[heavy])) {
+            rotate(heavy_child, 1 - heavy); // Zig-zag case needs a double rotation
+        }
+        rotate(node, heavy);
+    }
+
+    /**
+     * @brief Rotates the child in a slot above its parent.
+     * @param node The node moving down.
+     * @param up The slot of the child moving up.
+     */
+    void rotate(avl_node* node, size_t up) {
+        size_t down = 1 - up;
+        avl_node* raised = child(node, up);
+        Node<T>* parent = node->get_parent();
+        size_t parent_slot = parent && parent->get_children()[0] == node ? 0 : 1;
+
+        node->set_child(up, raised->get_children()[down]); // The inner subtree changes sides
+        if (parent) {
+            parent->set_child(parent_slot, raised);
+        } else {
+            root = raised;
+        }
+        raised->set_child(down, node);
+
+        update_height(node);
+        update_height(raised);
+    }
+};
+
+#endif // AVL_TREE_HPP
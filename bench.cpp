@@ -0,0 +1,355 @@
+// Tsadik88@gmail.com
+#include <iostream>
+#include <chrono>
+#include <deque>
+#include <thread>
+#include <vector>
+#include "node.hpp"
+#include "tree.hpp"
+#include "complex_batch.hpp"
+#include "avl_tree.hpp"
+#include "veb_layout.hpp"
+#include "eytzinger.hpp"
+#include <random>
+#include <algorithm>
+#include <sstream>
+
+using namespace std;
+
+// Seconds elapsed since start
+static double seconds_since(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Each thread fills its own subtree under the root, so inserts never share a parent
+void bench_concurrent_insert()
+{
+    const int per_thread = 200000;
+    for (bool with_aggregate : {false, true})
+    {
+        cout << "Concurrent insertion" << (with_aggregate ? " with a sum aggregate, " : ", ") << per_thread
+             << " nodes per thread:" << endl;
+        for (int threads : {1, 2, 4, 8, 16, 32})
+        {
+            Node<int> root(0);
+            Tree<int> tree(max(threads, 2));
+            tree.add_root(root);
+            if (with_aggregate)
+                tree.set_aggregate(sum_op<int>());
+            vector<deque<Node<int>>> nodes(threads);
+            for (int t = 0; t < threads; ++t)
+            {
+                nodes[t].emplace_back(t);
+                tree.add_sub_node_concurrent(root, nodes[t].front());
+            }
+
+            auto start = chrono::steady_clock::now();
+            vector<thread> workers;
+            for (int t = 0; t < threads; ++t)
+            {
+                workers.emplace_back([&, t]()
+                                     {
+                    for (int i = 1; i < per_thread; ++i)
+                    {
+                        nodes[t].emplace_back(i);
+                        tree.add_sub_node_concurrent(nodes[t][(i - 1) / 2], nodes[t].back());
+                    } });
+            }
+            for (auto &worker : workers)
+                worker.join();
+            double elapsed = seconds_since(start);
+
+            start = chrono::steady_clock::now();
+            tree.sync(); // Sizes and caches are folded in once, after the threads are done
+            double folded = seconds_since(start);
+
+            cout << "  " << threads << " threads: " << (threads * (per_thread - 1)) / elapsed / 1e6 << " M inserts/s, "
+                 << folded * 1e3 << " ms to fold" << endl;
+        }
+    }
+}
+
+// Sorting Complex values with the scalar operator< against the vectorized batch partition
+void bench_complex_sort()
+{
+    const size_t count = 1000000;
+    mt19937 random(42);
+    uniform_int_distribution<int> part(0, 1000);
+    vector<Complex> values;
+    for (size_t i = 0; i < count; ++i)
+        values.emplace_back(part(random), part(random));
+
+    auto start = chrono::steady_clock::now();
+    vector<Complex> sorted = values;
+    sort(sorted.begin(), sorted.end());
+    double scalar = seconds_since(start);
+
+    start = chrono::steady_clock::now();
+    ComplexBatch batch(values);
+    vector<size_t> order = batch.sorted_order();
+    double batched = seconds_since(start);
+
+    cout << "Complex ordering, " << count << " values:" << endl;
+    cout << "  std::sort with operator<: " << scalar * 1e3 << " ms" << endl;
+    cout << "  ComplexBatch::sorted_order: " << batched * 1e3 << " ms" << endl;
+
+    // Tree::top_k switches to the batch quickselect at an eighth of n, where it starts to win
+    for (size_t selected : {size_t(100), count / 32, count / 8, count / 2})
+    {
+        start = chrono::steady_clock::now();
+        vector<Complex> partial = values;
+        partial_sort(partial.begin(), partial.begin() + selected, partial.end());
+        double partial_scalar = seconds_since(start);
+
+        start = chrono::steady_clock::now();
+        vector<size_t> smallest = batch.smallest(selected);
+        double top = seconds_since(start);
+
+        cout << "  smallest " << selected << ": std::partial_sort " << partial_scalar * 1e3
+             << " ms, ComplexBatch::smallest " << top * 1e3 << " ms" << endl;
+    }
+}
+
+// Summing contiguous Complex values one at a time against the vectorized batch sum
+void bench_complex_sum()
+{
+    const size_t count = 10000000;
+    vector<Complex> values;
+    for (size_t i = 0; i < count; ++i)
+        values.emplace_back(double(i % 100), double(i % 7));
+
+    auto start = chrono::steady_clock::now();
+    Complex scalar;
+    for (const Complex &value : values)
+        scalar += value;
+    double scalar_time = seconds_since(start);
+
+    start = chrono::steady_clock::now();
+    Complex batched = ComplexBatch::sum(values.data(), values.size());
+    double batched_time = seconds_since(start);
+
+    vector<double> magnitudes(count);
+    start = chrono::steady_clock::now();
+    ComplexBatch::magnitude(values.data(), values.size(), magnitudes.data());
+    double magnitude_time = seconds_since(start);
+
+    cout << "Complex sum, " << count << " values (" << scalar << " / " << batched << "):" << endl;
+    cout << "  operator+= loop: " << scalar_time * 1e3 << " ms" << endl;
+    cout << "  ComplexBatch::sum: " << batched_time * 1e3 << " ms" << endl;
+    cout << "  ComplexBatch::magnitude: " << magnitude_time * 1e3 << " ms" << endl;
+}
+
+// Formatting and parsing Complex labels through streams against to_chars/from_chars
+void bench_complex_format()
+{
+    const size_t count = 1000000;
+    mt19937 random(7);
+    uniform_real_distribution<double> part(-1000, 1000);
+    vector<Complex> values;
+    for (size_t i = 0; i < count; ++i)
+        values.emplace_back(part(random), part(random));
+
+    auto start = chrono::steady_clock::now();
+    size_t stream_chars = 0;
+    for (const Complex &value : values)
+    {
+        ostringstream oss;
+        oss << value;
+        stream_chars += oss.str().size();
+    }
+    double stream_time = seconds_since(start);
+
+    start = chrono::steady_clock::now();
+    size_t chars = 0;
+    char buffer[64];
+    for (const Complex &value : values)
+        chars += to_chars(buffer, buffer + sizeof(buffer), value, chars_format::general, 6).ptr - buffer;
+    double precision_time = seconds_since(start);
+
+    start = chrono::steady_clock::now();
+    vector<string> texts;
+    for (const Complex &value : values)
+        texts.emplace_back(buffer, to_chars(buffer, buffer + sizeof(buffer), value).ptr);
+    double shortest_time = seconds_since(start);
+
+    start = chrono::steady_clock::now();
+    size_t matches = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        istringstream iss(texts[i]);
+        double real = 0, imag = 0;
+        char plus = 0, unit = 0;
+        iss >> real >> plus >> imag >> unit;
+        matches += Complex(real, imag) == values[i];
+    }
+    double stream_parse_time = seconds_since(start);
+
+    start = chrono::steady_clock::now();
+    size_t parsed = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        Complex value;
+        from_chars(texts[i].data(), texts[i].data() + texts[i].size(), value);
+        parsed += value == values[i];
+    }
+    double parse_time = seconds_since(start);
+
+    cout << "Complex formatting, " << count << " values (" << stream_chars << " / " << chars << " chars):" << endl;
+    cout << "  ostringstream: " << stream_time * 1e3 << " ms" << endl;
+    cout << "  to_chars, precision 6: " << precision_time * 1e3 << " ms" << endl;
+    cout << "  to_chars, shortest round-trip: " << shortest_time * 1e3 << " ms" << endl;
+    cout << "  istringstream parse: " << stream_parse_time * 1e3 << " ms (" << matches << " exact)" << endl;
+    cout << "  from_chars parse: " << parse_time * 1e3 << " ms (" << parsed << " exact)" << endl;
+}
+
+// Unbalanced Tree::insert against AvlTree on sorted, reverse and random insertion streams
+void bench_ordered_insert()
+{
+    const int chain_count = 20000;
+    const int count = 1000000;
+    mt19937 random(11);
+    cout << "Ordered insertion:" << endl;
+    for (const char *stream : {"sorted", "reverse", "random"})
+    {
+        auto make_input = [&](int size)
+        {
+            vector<int> input(size);
+            for (int i = 0; i < size; ++i)
+                input[i] = i;
+            if (string(stream) == "reverse")
+                reverse(input.begin(), input.end());
+            else if (string(stream) == "random")
+                shuffle(input.begin(), input.end(), random);
+            return input;
+        };
+
+        vector<int> small = make_input(chain_count);
+        auto start = chrono::steady_clock::now();
+        Tree<int> plain;
+        for (int value : small)
+            plain.insert(value);
+        double plain_time = seconds_since(start);
+
+        start = chrono::steady_clock::now();
+        AvlTree<int> small_balanced;
+        for (int value : small)
+            small_balanced.insert(value);
+        double small_time = seconds_since(start);
+
+        vector<int> large = make_input(count);
+        start = chrono::steady_clock::now();
+        AvlTree<int> balanced;
+        for (int value : large)
+            balanced.insert(value);
+        double balanced_time = seconds_since(start);
+
+        start = chrono::steady_clock::now();
+        size_t found = 0;
+        for (int value : large)
+            found += balanced.find(value) != nullptr;
+        double find_time = seconds_since(start);
+
+        cout << "  " << stream << ": Tree::insert " << chain_count << " in " << plain_time * 1e3 << " ms, AvlTree::insert "
+             << chain_count << " in " << small_time * 1e3 << " ms, " << count << " in " << balanced_time * 1e3
+             << " ms (height " << balanced.height() << "), " << found << " finds in " << find_time * 1e3 << " ms" << endl;
+    }
+}
+
+// Links count nodes holding 0..count-1 as a balanced search tree, allocated in random order
+// so that neighbours in the tree are far apart in memory; returns the root
+Node<int> &build_scattered_tree(int count, deque<Node<int>> &nodes, mt19937 &random)
+{
+    vector<int> slot_of(count);
+    for (int i = 0; i < count; ++i)
+        slot_of[i] = i;
+    shuffle(slot_of.begin(), slot_of.end(), random);
+    vector<int> value_of(count);
+    for (int value = 0; value < count; ++value)
+        value_of[slot_of[value]] = value;
+    for (int slot = 0; slot < count; ++slot)
+        nodes.emplace_back(value_of[slot]);
+
+    vector<pair<int, int>> ranges = {{0, count}};
+    while (!ranges.empty())
+    {
+        auto [lo, hi] = ranges.back();
+        ranges.pop_back();
+        int mid = lo + (hi - lo) / 2;
+        for (auto [child_lo, child_hi] : {make_pair(lo, mid), make_pair(mid + 1, hi)})
+        {
+            if (child_lo < child_hi)
+            {
+                nodes[slot_of[mid]].add_child(&nodes[slot_of[child_lo + (child_hi - child_lo) / 2]], 2);
+                ranges.emplace_back(child_lo, child_hi);
+            }
+        }
+    }
+    return nodes[slot_of[count / 2]];
+}
+
+// Times one lookup function over all keys, returning seconds and counting hits
+template <typename Lookup>
+double time_lookups(const vector<int> &keys, size_t &found, Lookup lookup)
+{
+    auto start = chrono::steady_clock::now();
+    found = 0;
+    for (int key : keys)
+        found += lookup(key);
+    return seconds_since(start);
+}
+
+// Searching a balanced binary tree with scattered nodes against its contiguous read-only layouts
+void bench_search_layouts()
+{
+    const int count = (1 << 23) - 1; // Hundreds of MB of nodes, well past the last-level cache
+    const int queries = 2000000;
+    mt19937 random(5);
+    deque<Node<int>> nodes;
+    Tree<int> tree;
+    tree.add_root(build_scattered_tree(count, nodes, random));
+
+    auto start = chrono::steady_clock::now();
+    VebLayout<int> veb(tree);
+    double veb_build = seconds_since(start);
+    start = chrono::steady_clock::now();
+    EytzingerLayout<int> eytzinger(tree);
+    double eytzinger_build = seconds_since(start);
+
+    uniform_int_distribution<int> pick(0, count - 1);
+    vector<int> keys(queries);
+    for (int &key : keys)
+        key = pick(random);
+    vector<int> sorted(count);
+    for (int i = 0; i < count; ++i)
+        sorted[i] = i;
+
+    size_t pointer_found, veb_found, eytzinger_found, sorted_found;
+    double pointer_time = time_lookups(keys, pointer_found, [&](int key)
+                                       { return tree.find(key) != nullptr; });
+    double veb_time = time_lookups(keys, veb_found, [&](int key)
+                                   { return veb.find(key) != VebLayout<int>::npos; });
+    double eytzinger_time = time_lookups(keys, eytzinger_found, [&](int key)
+                                         { return eytzinger.find(key) != EytzingerLayout<int>::npos; });
+    double sorted_time = time_lookups(keys, sorted_found, [&](int key)
+                                      { return binary_search(sorted.begin(), sorted.end(), key); });
+
+    cout << "Binary search tree lookups, " << count << " nodes, " << queries << " queries:" << endl;
+    cout << "  pointer layout (Tree::find): " << pointer_time * 1e3 << " ms (" << pointer_found << " found)" << endl;
+    cout << "  van Emde Boas layout: " << veb_time * 1e3 << " ms (" << veb_found << " found, built in "
+         << veb_build * 1e3 << " ms)" << endl;
+    cout << "  Eytzinger layout: " << eytzinger_time * 1e3 << " ms (" << eytzinger_found << " found, built in "
+         << eytzinger_build * 1e3 << " ms)" << endl;
+    cout << "  std::binary_search on a sorted vector: " << sorted_time * 1e3 << " ms (" << sorted_found << " found)" << endl;
+}
+
+int main()
+{
+    bench_concurrent_insert();
+    bench_complex_sort();
+    bench_complex_sum();
+    bench_complex_format();
+    bench_ordered_insert();
+    bench_search_layouts();
+    return 0;
+}
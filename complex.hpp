@@ -3,6 +3,10 @@
 #define COMPLEX_HPP
 
 #include <iostream>
+#include <cmath>
+#include <functional>
+#include <charconv>
+#include <system_error>
 
 /**
  * @class Complex
@@ -29,6 +33,101 @@ public:
      */
     double get_imag() const { return imag; }
 
+    /**
+     * @brief Computes the magnitude of the complex number.
+     * @return The distance from the origin, computed without intermediate overflow.
+     */
+    double abs() const { return std::hypot(real, imag); }
+
+    /**
+     * @brief Computes the squared magnitude of the complex number.
+     * @return real^2 + imag^2.
+     */
+    double norm() const { return real * real + imag * imag; }
+
+    /**
+     * @brief Computes the complex conjugate.
+     * @return The complex number with the imaginary part negated.
+     */
+    Complex conjugate() const { return Complex(real, -imag); }
+
+    /**
+     * @brief Adds another complex number to this one.
+     * @param other The complex number to add.
+     * @return A reference to this complex number.
+     */
+    Complex &operator+=(const Complex &other) {
+        real += other.real;
+        imag += other.imag;
+        return *this;
+    }
+
+    /**
+     * @brief Subtracts another complex number from this one.
+     * @param other The complex number to subtract.
+     * @return A reference to this complex number.
+     */
+    Complex &operator-=(const Complex &other) {
+        real -= other.real;
+        imag -= other.imag;
+        return *this;
+    }
+
+    /**
+     * @brief Multiplies this complex number by another one.
+     * @param other The complex number to multiply by.
+     * @return A reference to this complex number.
+     */
+    Complex &operator*=(const Complex &other) {
+        double r = real * other.real - imag * other.imag;
+        imag = real * other.imag + imag * other.real;
+        real = r;
+        return *this;
+    }
+
+    /**
+     * @brief Divides this complex number by another one.
+     * @param other The complex number to divide by.
+     * @return A reference to this complex number.
+     */
+    Complex &operator/=(const Complex &other) {
+        double denominator = other.norm();
+        double r = (real * other.real + imag * other.imag) / denominator;
+        imag = (imag * other.real - real * other.imag) / denominator;
+        real = r;
+        return *this;
+    }
+
+    /**
+     * @brief Negates the complex number.
+     * @return The complex number with both parts negated.
+     */
+    Complex operator-() const { return Complex(-real, -imag); }
+
+    /**
+     * @brief Adds two complex numbers.
+     * @return The sum.
+     */
+    friend Complex operator+(Complex a, const Complex &b) { return a += b; }
+
+    /**
+     * @brief Subtracts two complex numbers.
+     * @return The difference.
+     */
+    friend Complex operator-(Complex a, const Complex &b) { return a -= b; }
+
+    /**
+     * @brief Multiplies two complex numbers.
+     * @return The product.
+     */
+    friend Complex operator*(Complex a, const Complex &b) { return a *= b; }
+
+    /**
+     * @brief Divides two complex numbers.
+     * @return The quotient.
+     */
+    friend Complex operator/(Complex a, const Complex &b) { return a /= b; }
+
     /**
      * @brief Overloads the insertion (<<) operator to print the complex number in the form "real+imagi".
      * @param os The output stream.
@@ -40,6 +139,62 @@ public:
         return os;
     }
 
+    /**
+     * @brief Formats the complex number as "real+imagi" using the shortest round-trip form of each part.
+     *
+     * The output is locale-independent and from_chars reads it back to the identical value.
+     *
+     * @param first The start of the output buffer.
+     * @param last The end of the output buffer.
+     * @param c The complex number to format.
+     * @return The end of the written characters, or errc::value_too_large if the buffer is too small.
+     */
+    friend std::to_chars_result to_chars(char *first, char *last, const Complex &c) {
+        return format(first, last, c, [](char *begin, char *end, double part) { return std::to_chars(begin, end, part); });
+    }
+
+    /**
+     * @brief Formats the complex number as "real+imagi" with a fixed format and precision.
+     *
+     * With std::chars_format::general and precision 6 the output matches operator<< under the
+     * default stream settings, without the stream and locale overhead.
+     *
+     * @param first The start of the output buffer.
+     * @param last The end of the output buffer.
+     * @param c The complex number to format.
+     * @param fmt The floating-point format of each part.
+     * @param precision The precision of each part.
+     * @return The end of the written characters, or errc::value_too_large if the buffer is too small.
+     */
+    friend std::to_chars_result to_chars(char *first, char *last, const Complex &c, std::chars_format fmt, int precision) {
+        return format(first, last, c, [fmt, precision](char *begin, char *end, double part) {
+            return std::to_chars(begin, end, part, fmt, precision);
+        });
+    }
+
+    /**
+     * @brief Parses a complex number written as "real+imagi", "real-imagi" or "real+-imagi".
+     * @param first The start of the input.
+     * @param last The end of the input.
+     * @param c Receives the parsed value; unchanged on error.
+     * @return The end of the parsed characters, or errc::invalid_argument with ptr == first.
+     */
+    friend std::from_chars_result from_chars(const char *first, const char *last, Complex &c) {
+        double re = 0;
+        double im = 0;
+        std::from_chars_result result = std::from_chars(first, last, re);
+        if (result.ec != std::errc() || result.ptr == last || (*result.ptr != '+' && *result.ptr != '-')) {
+            return {first, std::errc::invalid_argument};
+        }
+        const char *imag_begin = *result.ptr == '+' ? result.ptr + 1 : result.ptr; // A '-' belongs to the number
+        result = std::from_chars(imag_begin, last, im);
+        if (result.ec != std::errc() || result.ptr == last || *result.ptr != 'i') {
+            return {first, std::errc::invalid_argument};
+        }
+        c = Complex(re, im);
+        return {result.ptr + 1, std::errc()};
+    }
+
     /**
      * @brief Overloads the greater than (>) operator to compare two complex numbers.
      *        Comparison is based on the real part first, then the imaginary part if the real parts are equal.
@@ -80,8 +235,39 @@ public:
     }
 
 private:
+    /**
+     * @brief Writes "real+imagi" with the given formatter for each part.
+     */
+    template <typename Formatter>
+    static std::to_chars_result format(char *first, char *last, const Complex &c, Formatter part) {
+        std::to_chars_result result = part(first, last, c.real);
+        if (result.ec != std::errc() || result.ptr == last) {
+            return {last, std::errc::value_too_large};
+        }
+        *result.ptr++ = '+';
+        result = part(result.ptr, last, c.imag);
+        if (result.ec != std::errc() || result.ptr == last) {
+            return {last, std::errc::value_too_large};
+        }
+        *result.ptr++ = 'i';
+        return result;
+    }
+
     double real; ///< The real part of the complex number.
     double imag; ///< The imaginary part of the complex number.
 };
 
+/**
+ * @brief Hash for Complex, consistent with operator== (0.0 and -0.0 hash alike).
+ */
+namespace std {
+template <>
+struct hash<Complex> {
+    size_t operator()(const Complex &c) const {
+        size_t h = hash<double>()(c.get_real() + 0.0);
+        return h ^ (hash<double>()(c.get_imag() + 0.0) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2));
+    }
+};
+} // namespace std
+
 #endif // COMPLEX_HPP
@@ -0,0 +1,421 @@
+// Tsadik88@gmail.com
+#ifndef COMPLEX_BATCH_HPP
+#define COMPLEX_BATCH_HPP
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+#include "complex.hpp"
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+/**
+ * @class ComplexBatch
+ * @brief A batch of complex numbers stored as separate arrays of real and imaginary parts.
+ *
+ * The structure-of-arrays layout lets the lexicographic comparison of Complex run four
+ * elements at a time with AVX2 when the code is compiled with AVX2 enabled, and one
+ * element at a time otherwise. Both paths give the same results as Complex::operator<.
+ *
+ * The static sum, magnitude and dot functions work directly on contiguous arrays of
+ * Complex, whose interleaved (real, imag) layout is loaded two numbers per AVX2 register.
+ */
+class ComplexBatch {
+public:
+    /**
+     * @brief Constructs an empty batch.
+     */
+    ComplexBatch() = default;
+
+    /**
+     * @brief Constructs a batch holding copies of the given numbers.
+     * @param values The complex numbers to store.
+     */
+    explicit ComplexBatch(const std::vector<Complex>& values) {
+        reals.reserve(values.size());
+        imags.reserve(values.size());
+        for (const Complex& value : values) {
+            push_back(value);
+        }
+    }
+
+    /**
+     * @brief Appends a complex number to the batch.
+     * @param value The complex number to append.
+     */
+    void push_back(const Complex& value) {
+        reals.push_back(value.get_real());
+        imags.push_back(value.get_imag());
+    }
+
+    /**
+     * @brief Gets the number of elements in the batch.
+     * @return The number of elements.
+     */
+    size_t size() const { return reals.size(); }
+
+    /**
+     * @brief Gets an element of the batch.
+     * @param index The position of the element.
+     * @return The complex number at the position.
+     */
+    Complex get(size_t index) const { return Complex(reals[index], imags[index]); }
+
+    /**
+     * @brief Compares every element with a pivot using Complex::operator<.
+     * @param pivot The value to compare against.
+     * @param mask Receives 1 for each element less than the pivot and 0 otherwise; must hold size() bytes.
+     * @return The number of elements less than the pivot.
+     */
+    size_t less_than(const Complex& pivot, uint8_t* mask) const {
+        return compare(reals.data(), imags.data(), size(), pivot, mask, false);
+    }
+
+    /**
+     * @brief Compares every element with a pivot using Complex::operator>.
+     * @param pivot The value to compare against.
+     * @param mask Receives 1 for each element greater than the pivot and 0 otherwise; must hold size() bytes.
+     * @return The number of elements greater than the pivot.
+     */
+    size_t greater_than(const Complex& pivot, uint8_t* mask) const {
+        return compare(reals.data(), imags.data(), size(), pivot, mask, true);
+    }
+
+    /**
+     * @brief Computes the positions of the elements in ascending order.
+     * @return A permutation of [0, size()) listing the elements from smallest to largest.
+     */
+    std::vector<size_t> sorted_order() const {
+        Workspace work(*this);
+        sort_range(work, 0, size());
+        return work.side[0].index;
+    }
+
+    /**
+     * @brief Computes the positions of the smallest elements in ascending order.
+     *
+     * Uses quickselect over the vectorized partition, then sorts only the selected prefix.
+     *
+     * @param count The number of elements to select.
+     * @return The positions of the min(count, size()) smallest elements, smallest first.
+     */
+    std::vector<size_t> smallest(size_t count) const {
+        if (count > size()) {
+            count = size();
+        }
+        Workspace work(*this);
+        size_t lo = 0;
+        size_t hi = size();
+        int from = 0;
+        while (hi - lo > small_range && lo < count && count < hi) {
+            std::pair<size_t, size_t> equal = partition(work, from, lo, hi);
+            from = 1 - from;
+            if (count <= equal.first) {
+                hi = equal.first;
+            } else if (count >= equal.second) {
+                work.move_to_front(from, lo, equal.second); // Everything below the pivot run is selected
+                lo = equal.second;
+            } else {
+                hi = count; // The boundary falls among elements equal to the pivot
+                break;
+            }
+        }
+        size_t end = lo < count ? hi : count; // Everything before the bound is no larger than what follows
+        work.move_to_front(from, lo, end);
+        sort_range(work, 0, end);
+        work.side[0].index.resize(count);
+        return work.side[0].index;
+    }
+
+    /**
+     * @brief Sums a contiguous array of complex numbers.
+     * @param values The first element of the array.
+     * @param count The number of elements.
+     * @return The sum; with AVX2 the additions are reassociated in two lanes.
+     */
+    static Complex sum(const Complex* values, size_t count) {
+        const double* data = as_doubles(values);
+        double real = 0;
+        double imag = 0;
+        size_t i = 0;
+#ifdef __AVX2__
+        __m256d total = _mm256_setzero_pd();
+        for (; i + 2 <= count; i += 2) {
+            total = _mm256_add_pd(total, _mm256_loadu_pd(data + 2 * i));
+        }
+        __m128d halves = _mm_add_pd(_mm256_castpd256_pd128(total), _mm256_extractf128_pd(total, 1));
+        real = _mm_cvtsd_f64(halves);
+        imag = _mm_cvtsd_f64(_mm_unpackhi_pd(halves, halves));
+#endif
+        for (; i < count; ++i) {
+            real += data[2 * i];
+            imag += data[2 * i + 1];
+        }
+        return Complex(real, imag);
+    }
+
+    /**
+     * @brief Computes the magnitude of each element of a contiguous array.
+     *
+     * Uses sqrt(real^2 + imag^2), which matches Complex::abs() except for parts
+     * large enough for the squares to overflow.
+     *
+     * @param values The first element of the array.
+     * @param count The number of elements.
+     * @param out Receives the magnitudes; must hold count values.
+     */
+    static void magnitude(const Complex* values, size_t count, double* out) {
+        const double* data = as_doubles(values);
+        size_t i = 0;
+#ifdef __AVX2__
+        for (; i + 4 <= count; i += 4) {
+            __m256d a = _mm256_loadu_pd(data + 2 * i);
+            __m256d b = _mm256_loadu_pd(data + 2 * i + 4);
+            __m256d norms = _mm256_hadd_pd(_mm256_mul_pd(a, a), _mm256_mul_pd(b, b)); // c0, c2, c1, c3
+            norms = _mm256_permute4x64_pd(norms, 0xD8);                                // c0, c1, c2, c3
+            _mm256_storeu_pd(out + i, _mm256_sqrt_pd(norms));
+        }
+#endif
+        for (; i < count; ++i) {
+            out[i] = std::sqrt(data[2 * i] * data[2 * i] + data[2 * i + 1] * data[2 * i + 1]);
+        }
+    }
+
+    /**
+     * @brief Computes the unconjugated dot product of two contiguous arrays.
+     * @param a The first element of the first array.
+     * @param b The first element of the second array.
+     * @param count The number of elements in each array.
+     * @return The sum of a[i] * b[i].
+     */
+    static Complex dot(const Complex* a, const Complex* b, size_t count) {
+        const double* x = as_doubles(a);
+        const double* y = as_doubles(b);
+        double real = 0;
+        double imag = 0;
+        size_t i = 0;
+#ifdef __AVX2__
+        __m256d total = _mm256_setzero_pd();
+        for (; i + 2 <= count; i += 2) {
+            __m256d u = _mm256_loadu_pd(x + 2 * i);
+            __m256d v = _mm256_loadu_pd(y + 2 * i);
+            __m256d v_real = _mm256_movedup_pd(v);          // vr, vr
+            __m256d v_imag = _mm256_permute_pd(v, 0xF);     // vi, vi
+            __m256d u_swapped = _mm256_permute_pd(u, 0x5);  // ui, ur
+            __m256d product = _mm256_addsub_pd(_mm256_mul_pd(u, v_real), _mm256_mul_pd(u_swapped, v_imag));
+            total = _mm256_add_pd(total, product);
+        }
+        __m128d halves = _mm_add_pd(_mm256_castpd256_pd128(total), _mm256_extractf128_pd(total, 1));
+        real = _mm_cvtsd_f64(halves);
+        imag = _mm_cvtsd_f64(_mm_unpackhi_pd(halves, halves));
+#endif
+        for (; i < count; ++i) {
+            real += x[2 * i] * y[2 * i] - x[2 * i + 1] * y[2 * i + 1];
+            imag += x[2 * i] * y[2 * i + 1] + x[2 * i + 1] * y[2 * i];
+        }
+        return Complex(real, imag);
+    }
+
+private:
+    static constexpr size_t small_range = 16; ///< Ranges at most this long are insertion sorted.
+
+    std::vector<double> reals; ///< Real parts.
+    std::vector<double> imags; ///< Imaginary parts.
+
+    static_assert(sizeof(Complex) == 2 * sizeof(double), "Complex must be two packed doubles");
+
+    /**
+     * @brief Views an array of Complex as interleaved real and imaginary parts.
+     */
+    static const double* as_doubles(const Complex* values) { return reinterpret_cast<const double*>(values); }
+
+    /**
+     * @brief Two copies of the batch; partitions read one side and write the other.
+     *
+     * Only the positions are needed as a result, so finished ranges copy their indices
+     * back to side 0 instead of copying every partitioned range back.
+     */
+    struct Workspace {
+        struct Buffer {
+            std::vector<double> reals, imags;
+            std::vector<size_t> index;
+        };
+
+        explicit Workspace(const ComplexBatch& batch) : group(batch.size()) {
+            side[0].reals = batch.reals;
+            side[0].imags = batch.imags;
+            side[0].index.resize(batch.size());
+            for (size_t i = 0; i < batch.size(); ++i) {
+                side[0].index[i] = i;
+            }
+            side[1].reals.resize(batch.size());
+            side[1].imags.resize(batch.size());
+            side[1].index.resize(batch.size());
+        }
+
+        void move_to_front(int from, size_t lo, size_t hi) {
+            if (from == 1) {
+                std::copy(side[1].reals.begin() + lo, side[1].reals.begin() + hi, side[0].reals.begin() + lo);
+                std::copy(side[1].imags.begin() + lo, side[1].imags.begin() + hi, side[0].imags.begin() + lo);
+                std::copy(side[1].index.begin() + lo, side[1].index.begin() + hi, side[0].index.begin() + lo);
+            }
+        }
+
+        Buffer side[2];
+        std::vector<uint8_t> group;
+    };
+
+    /**
+     * @brief The comparison kernel: lexicographic less-than (or greater-than) against a pivot.
+     */
+    static size_t compare(const double* re, const double* im, size_t n, const Complex& pivot, uint8_t* mask,
+                          bool greater) {
+        const double pr = pivot.get_real();
+        const double pi = pivot.get_imag();
+        size_t count = 0;
+        size_t i = 0;
+#ifdef __AVX2__
+        const __m256d vpr = _mm256_set1_pd(pr);
+        const __m256d vpi = _mm256_set1_pd(pi);
+        for (; i + 4 <= n; i += 4) {
+            __m256d r = _mm256_loadu_pd(re + i);
+            __m256d m = _mm256_loadu_pd(im + i);
+            __m256d real_order = greater ? _mm256_cmp_pd(r, vpr, _CMP_GT_OQ) : _mm256_cmp_pd(r, vpr, _CMP_LT_OQ);
+            __m256d real_equal = _mm256_cmp_pd(r, vpr, _CMP_EQ_OQ);
+            __m256d imag_order = greater ? _mm256_cmp_pd(m, vpi, _CMP_GT_OQ) : _mm256_cmp_pd(m, vpi, _CMP_LT_OQ);
+            int bits = _mm256_movemask_pd(_mm256_or_pd(real_order, _mm256_and_pd(real_equal, imag_order)));
+            mask[i] = bits & 1;
+            mask[i + 1] = (bits >> 1) & 1;
+            mask[i + 2] = (bits >> 2) & 1;
+            mask[i + 3] = (bits >> 3) & 1;
+            count += __builtin_popcount(bits);
+        }
+#endif
+        for (; i < n; ++i) {
+            bool result = greater ? (re[i] > pr || (re[i] == pr && im[i] > pi))
+                                  : (re[i] < pr || (re[i] == pr && im[i] < pi));
+            mask[i] = result;
+            count += result;
+        }
+        return count;
+    }
+
+    /**
+     * @brief One-pass three-way comparison kernel: writes 0, 1 or 2 for less, equal or greater.
+     */
+    static void classify(const double* re, const double* im, size_t n, const Complex& pivot, uint8_t* group,
+                         size_t& less_count, size_t& greater_count) {
+        const double pr = pivot.get_real();
+        const double pi = pivot.get_imag();
+        size_t i = 0;
+#ifdef __AVX2__
+        const __m256d vpr = _mm256_set1_pd(pr);
+        const __m256d vpi = _mm256_set1_pd(pi);
+        for (; i + 4 <= n; i += 4) {
+            __m256d r = _mm256_loadu_pd(re + i);
+            __m256d m = _mm256_loadu_pd(im + i);
+            __m256d real_equal = _mm256_cmp_pd(r, vpr, _CMP_EQ_OQ);
+            __m256d lt = _mm256_or_pd(_mm256_cmp_pd(r, vpr, _CMP_LT_OQ),
+                                      _mm256_and_pd(real_equal, _mm256_cmp_pd(m, vpi, _CMP_LT_OQ)));
+            __m256d gt = _mm256_or_pd(_mm256_cmp_pd(r, vpr, _CMP_GT_OQ),
+                                      _mm256_and_pd(real_equal, _mm256_cmp_pd(m, vpi, _CMP_GT_OQ)));
+            int lt_bits = _mm256_movemask_pd(lt);
+            int gt_bits = _mm256_movemask_pd(gt);
+            for (int j = 0; j < 4; ++j) {
+                group[i + j] = uint8_t(1 - ((lt_bits >> j) & 1) + ((gt_bits >> j) & 1));
+            }
+            less_count += __builtin_popcount(lt_bits);
+            greater_count += __builtin_popcount(gt_bits);
+        }
+#endif
+        for (; i < n; ++i) {
+            bool lt = re[i] < pr || (re[i] == pr && im[i] < pi);
+            bool gt = re[i] > pr || (re[i] == pr && im[i] > pi);
+            group[i] = uint8_t(1 - lt + gt);
+            less_count += lt;
+            greater_count += gt;
+        }
+    }
+
+    /**
+     * @brief Three-way partitions [lo, hi) of one side into the other around a median-of-three pivot.
+     * @return The range [first, second) holding the elements equal to the pivot.
+     */
+    static std::pair<size_t, size_t> partition(Workspace& work, int from, size_t lo, size_t hi) {
+        const Workspace::Buffer& src = work.side[from];
+        Workspace::Buffer& dst = work.side[1 - from];
+        size_t n = hi - lo;
+        size_t a = lo, b = lo + n / 2, c = hi - 1;
+        auto less = [&](size_t x, size_t y) {
+            return src.reals[x] < src.reals[y] || (src.reals[x] == src.reals[y] && src.imags[x] < src.imags[y]);
+        };
+        if (less(b, a)) std::swap(a, b);
+        if (less(c, b)) std::swap(b, c);
+        if (less(b, a)) std::swap(a, b);
+        Complex pivot(src.reals[b], src.imags[b]);
+
+        size_t less_count = 0;
+        size_t greater_count = 0;
+        classify(&src.reals[lo], &src.imags[lo], n, pivot, &work.group[lo], less_count, greater_count);
+        size_t position[3] = {lo, lo + less_count, hi - greater_count};
+        for (size_t i = lo; i < hi; ++i) {
+            size_t dest = position[work.group[i]]++;
+            dst.reals[dest] = src.reals[i];
+            dst.imags[dest] = src.imags[i];
+            dst.index[dest] = src.index[i];
+        }
+        return {lo + less_count, hi - greater_count};
+    }
+
+    /**
+     * @brief Sorts the positions in [lo, hi) of side 0 with a quicksort over the vectorized partition.
+     */
+    static void sort_range(Workspace& work, size_t lo, size_t hi) {
+        struct Range {
+            size_t lo, hi;
+            int side;
+        };
+        std::vector<Range> pending = {{lo, hi, 0}};
+        while (!pending.empty()) {
+            Range range = pending.back();
+            pending.pop_back();
+            if (range.hi - range.lo <= small_range) {
+                insertion_sort(work.side[range.side], range.lo, range.hi);
+                work.move_to_front(range.side, range.lo, range.hi);
+                continue;
+            }
+            std::pair<size_t, size_t> equal = partition(work, range.side, range.lo, range.hi);
+            int other = 1 - range.side;
+            work.move_to_front(other, equal.first, equal.second); // Elements equal to the pivot are in place
+            pending.push_back({range.lo, equal.first, other});
+            pending.push_back({equal.second, range.hi, other});
+        }
+    }
+
+    /**
+     * @brief Sorts a short range of one side in place.
+     */
+    static void insertion_sort(Workspace::Buffer& buffer, size_t lo, size_t hi) {
+        for (size_t i = lo + 1; i < hi; ++i) {
+            double r = buffer.reals[i];
+            double m = buffer.imags[i];
+            size_t idx = buffer.index[i];
+            size_t j = i;
+            while (j > lo && (r < buffer.reals[j - 1] || (r == buffer.reals[j - 1] && m < buffer.imags[j - 1]))) {
+                buffer.reals[j] = buffer.reals[j - 1];
+                buffer.imags[j] = buffer.imags[j - 1];
+                buffer.index[j] = buffer.index[j - 1];
+                --j;
+            }
+            buffer.reals[j] = r;
+            buffer.imags[j] = m;
+            buffer.index[j] = idx;
+        }
+    }
+};
+
+#endif // COMPLEX_BATCH_HPP
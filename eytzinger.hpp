@@ -0,0 +1,174 @@
+// Tsadik88@gmail.com
+#ifndef EYTZINGER_HPP
+#define EYTZINGER_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+#include "node.hpp"
+#include "tree.hpp"
+
+/**
+ * @class EytzingerLayout
+ * @brief A read-only sorted index stored as an implicit binary tree in BFS (Eytzinger) order.
+ *
+ * The values of a binary search Tree are rearranged so that position 1 holds the root
+ * and positions 2i and 2i + 1 hold the children of position i. Searches need no child
+ * pointers. The next comparison is chosen with arithmetic instead of a branch, and the
+ * block of descendants four levels down is prefetched while the current levels are
+ * compared.
+ *
+ * @tparam T The type of the values stored in the tree. It must define operator<.
+ */
+template <typename T>
+class EytzingerLayout {
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1); ///< Returned when no value qualifies.
+
+    /**
+     * @brief Copies the values of a binary search tree in Eytzinger order.
+     * @param tree The tree to copy, ordered as a binary search tree with slot 0 as the left child.
+     * @throws std::runtime_error if a node has more than two children.
+     */
+    explicit EytzingerLayout(const Tree<T>& tree) {
+        std::vector<T> sorted;
+        std::vector<Node<T>*> stack;
+        Node<T>* current = tree.get_root();
+        while (current || !stack.empty()) {
+            while (current) {
+                stack.push_back(current);
+                current = child(current, 0);
+            }
+            current = stack.back();
+            stack.pop_back();
+            sorted.push_back(current->get_value());
+            current = child(current, 1);
+        }
+        build(sorted);
+    }
+
+    /**
+     * @brief Copies already sorted values in Eytzinger order.
+     * @param sorted The values in ascending order.
+     */
+    explicit EytzingerLayout(const std::vector<T>& sorted) { build(sorted); }
+
+    /**
+     * @brief Gets the number of values.
+     * @return The number of values.
+     */
+    size_t size() const { return values.size() - 1; }
+
+    /**
+     * @brief Gets the value at a layout position.
+     * @param index A position returned by lower_bound, find or next.
+     * @return A constant reference to the value.
+     */
+    const T& value(size_t index) const { return values[index]; }
+
+    /**
+     * @brief Finds the first value that is not less than the given one.
+     *
+     * The loop runs floor(log2(n)) + 1 times when the search path ends on the last level
+     * and floor(log2(n)) times otherwise; the counts agree only when n = 2^m - 1. Inside
+     * the loop the comparison result feeds the index arithmetic, so only the loop exit
+     * depends on the data.
+     *
+     * @param value The value to search for.
+     * @return The layout position of the value, or npos if every value is less.
+     */
+    size_t lower_bound(const T& value) const {
+        size_t n = size();
+        size_t k = 1;
+        while (k <= n) {
+            prefetch(k * lines_ahead); // First of the 16 descendants four levels down
+            k = 2 * k + static_cast<size_t>(values[k] < value);
+        }
+        k >>= __builtin_ffsll(~static_cast<long long>(k)); // Undo the right turns taken after the answer
+        return k == 0 ? npos : k;
+    }
+
+    /**
+     * @brief Finds a value equivalent to the given one.
+     * @param value The value to search for.
+     * @return The layout position of the value, or npos if it is absent.
+     */
+    size_t find(const T& value) const {
+        size_t k = lower_bound(value);
+        return k != npos && !(value < values[k]) ? k : npos;
+    }
+
+    /**
+     * @brief Gets the position of the next larger value, for scanning a range after lower_bound.
+     * @param index A layout position.
+     * @return The position of the next value in sorted order, or npos after the largest.
+     */
+    size_t next(size_t index) const {
+        size_t n = size();
+        if (2 * index + 1 <= n) {
+            index = 2 * index + 1; // Leftmost node of the right subtree
+            while (2 * index <= n) {
+                index *= 2;
+            }
+            return index;
+        }
+        index >>= __builtin_ffsll(~static_cast<long long>(index)); // Climb out of right subtrees
+        return index == 0 ? npos : index;
+    }
+
+    /**
+     * @brief Gets the position of the smallest value.
+     * @return The position, or npos for an empty layout.
+     */
+    size_t first() const {
+        if (size() == 0) {
+            return npos;
+        }
+        size_t index = 1;
+        while (2 * index <= size()) {
+            index *= 2;
+        }
+        return index;
+    }
+
+private:
+    /// Multiplier from a position to its first descendant four levels down. The 16 descendants are
+    /// contiguous, 64 bytes for a 4-byte T, but std::vector does not align them to a cache line,
+    /// so they may straddle two lines and the prefetch only fetches the first.
+    static constexpr size_t lines_ahead = 16;
+
+    std::vector<T> values; ///< Values in Eytzinger order; position 0 is unused.
+
+    /**
+     * @brief Gets a child slot of a source node, or nullptr if the slot is empty or missing.
+     */
+    static Node<T>* child(Node<T>* node, size_t slot) {
+        const auto& children = node->get_children();
+        if (children.size() > 2) {
+            throw std::runtime_error("Eytzinger layout requires a binary tree.");
+        }
+        return slot < children.size() ? children[slot] : nullptr;
+    }
+
+    /**
+     * @brief Places sorted values by walking the implicit tree in in-order.
+     */
+    void build(const std::vector<T>& sorted) {
+        values.assign(sorted.size() + 1, sorted.empty() ? T() : sorted.front());
+        size_t index = first();
+        for (const T& value : sorted) {
+            values[index] = value;
+            index = next(index);
+        }
+    }
+
+    /**
+     * @brief Prefetches a position that may lie past the end; prefetches never fault.
+     */
+    void prefetch(size_t index) const {
+        __builtin_prefetch(reinterpret_cast<const void*>(reinterpret_cast<uintptr_t>(values.data()) + index * sizeof(T)));
+    }
+};
+
+#endif // EYTZINGER_HPP
@@ -0,0 +1,287 @@
+// Tsadik88@gmail.com
+#ifndef LOUDS_HPP
+#define LOUDS_HPP
+
+#include <vector>
+#include <queue>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+#include "node.hpp"
+#include "tree.hpp"
+
+/**
+ * @class BitVector
+ * @brief An append-only bit vector with constant-time rank and logarithmic-time select.
+ *
+ * A cumulative count of set bits is kept for every 512-bit block, which adds
+ * 64 bits of directory per 512 bits of payload.
+ */
+class BitVector {
+public:
+    /**
+     * @brief Appends a bit to the end of the vector.
+     * @param bit The bit to append.
+     */
+    void push_back(bool bit) {
+        if (length % 64 == 0) {
+            words.push_back(0);
+        }
+        if (bit) {
+            words.back() |= uint64_t(1) << (length % 64);
+        }
+        ++length;
+    }
+
+    /**
+     * @brief Builds the rank directory. Must be called after the last push_back.
+     */
+    void build() {
+        blocks.assign(words.size() / 8 + 2, 0);
+        for (size_t w = 0; w < words.size(); ++w) {
+            blocks[w / 8 + 1] += __builtin_popcountll(words[w]);
+        }
+        for (size_t b = 1; b < blocks.size(); ++b) {
+            blocks[b] += blocks[b - 1];
+        }
+    }
+
+    /**
+     * @brief Gets the bit at a position.
+     * @param pos The position of the bit.
+     * @return The bit value.
+     */
+    bool operator[](size_t pos) const { return (words[pos / 64] >> (pos % 64)) & 1; }
+
+    /**
+     * @brief Gets the number of bits in the vector.
+     * @return The number of bits.
+     */
+    size_t size() const { return length; }
+
+    /**
+     * @brief Counts the set bits before a position.
+     * @param pos The exclusive end of the counted range.
+     * @return The number of set bits in [0, pos).
+     */
+    size_t rank1(size_t pos) const {
+        size_t word = pos / 64;
+        size_t count = blocks[word / 8];
+        for (size_t w = word / 8 * 8; w < word; ++w) {
+            count += __builtin_popcountll(words[w]);
+        }
+        if (pos % 64) {
+            count += __builtin_popcountll(words[word] & ((uint64_t(1) << (pos % 64)) - 1));
+        }
+        return count;
+    }
+
+    /**
+     * @brief Counts the clear bits before a position.
+     * @param pos The exclusive end of the counted range.
+     * @return The number of clear bits in [0, pos).
+     */
+    size_t rank0(size_t pos) const { return pos - rank1(pos); }
+
+    /**
+     * @brief Finds the position of the j-th set bit (1-based).
+     * @param j The index of the set bit.
+     * @return The position of the bit.
+     */
+    size_t select1(size_t j) const { return select(j, true); }
+
+    /**
+     * @brief Finds the position of the j-th clear bit (1-based).
+     * @param j The index of the clear bit.
+     * @return The position of the bit.
+     */
+    size_t select0(size_t j) const { return select(j, false); }
+
+    /**
+     * @brief Gets the memory used by the bits and the rank directory.
+     * @return The number of bytes used.
+     */
+    size_t memory_bytes() const { return words.size() * sizeof(uint64_t) + blocks.size() * sizeof(uint64_t); }
+
+private:
+    size_t select(size_t j, bool one) const {
+        // Binary search the block directory, then scan at most eight words
+        size_t lo = 0;
+        size_t hi = blocks.size() - 1;
+        while (hi - lo > 1) {
+            size_t mid = (lo + hi) / 2;
+            size_t before = one ? blocks[mid] : mid * 512 - blocks[mid];
+            if (before < j) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+        size_t remaining = j - (one ? blocks[lo] : lo * 512 - blocks[lo]);
+        for (size_t w = lo * 8; w < words.size(); ++w) {
+            uint64_t bits = one ? words[w] : ~words[w];
+            size_t count = __builtin_popcountll(bits);
+            if (remaining <= count) {
+                for (size_t i = 1; i < remaining; ++i) {
+                    bits &= bits - 1; // Clear the lowest set bits before the target
+                }
+                return w * 64 + __builtin_ctzll(bits);
+            }
+            remaining -= count;
+        }
+        throw std::out_of_range("Select index out of range");
+    }
+
+    std::vector<uint64_t> words;  ///< The bits, 64 per word.
+    std::vector<uint64_t> blocks; ///< Set bits before each 512-bit block.
+    size_t length = 0;            ///< The number of bits.
+};
+
+/**
+ * @class LoudsTree
+ * @brief A read-only tree stored as a LOUDS bit vector and a packed value array.
+ *
+ * Nodes are numbered in BFS order starting at 0 for the root. The shape takes
+ * 2n + 1 bits plus the rank directory, and values are stored contiguously in BFS order.
+ *
+ * @tparam T The type of the values stored in the tree.
+ */
+template <typename T>
+class LoudsTree {
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1); ///< Returned when a node does not exist.
+
+    /**
+     * @brief Encodes the shape and values of a pointer-based tree.
+     * @param tree The tree to encode.
+     */
+    explicit LoudsTree(const Tree<T>& tree) {
+        bits.push_back(true); // Super-root pointing at the root
+        bits.push_back(false);
+        std::queue<Node<T>*> nodes;
+        if (tree.get_root()) {
+            nodes.push(tree.get_root());
+        }
+        while (!nodes.empty()) {
+            Node<T>* current = nodes.front();
+            nodes.pop();
+            values.push_back(current->get_value());
+            for (auto child : current->get_children()) {
+                if (child) {
+                    bits.push_back(true);
+                    nodes.push(child);
+                }
+            }
+            bits.push_back(false);
+        }
+        bits.build();
+    }
+
+    /**
+     * @brief Gets the number of nodes.
+     * @return The number of nodes.
+     */
+    size_t size() const { return values.size(); }
+
+    /**
+     * @brief Gets the value of a node.
+     * @param node The node number.
+     * @return A constant reference to the value.
+     */
+    const T& value(size_t node) const { return values[node]; }
+
+    /**
+     * @brief Gets the parent of a node.
+     * @param node The node number.
+     * @return The parent node number, or npos for the root.
+     */
+    size_t parent(size_t node) const {
+        size_t zeros = bits.rank0(bits.select1(node + 1));
+        return zeros == 0 ? npos : zeros - 1;
+    }
+
+    /**
+     * @brief Gets the number of children of a node.
+     * @param node The node number.
+     * @return The number of children.
+     */
+    size_t child_count(size_t node) const { return bits.select0(node + 2) - bits.select0(node + 1) - 1; }
+
+    /**
+     * @brief Gets a child of a node.
+     * @param node The node number.
+     * @param index The index of the child among its siblings.
+     * @return The child node number.
+     * @throws std::out_of_range if the node has no child at the index.
+     */
+    size_t child(size_t node, size_t index) const {
+        size_t start = bits.select0(node + 1) + 1;
+        if (start + index >= bits.size() || !bits[start + index]) {
+            throw std::out_of_range("Index out of range");
+        }
+        return bits.rank1(start) + index;
+    }
+
+    /**
+     * @brief Gets the first child of a node.
+     * @param node The node number.
+     * @return The first child node number, or npos for a leaf.
+     */
+    size_t first_child(size_t node) const {
+        size_t start = bits.select0(node + 1) + 1;
+        return start < bits.size() && bits[start] ? bits.rank1(start) : npos;
+    }
+
+    /**
+     * @brief Gets the next sibling of a node.
+     * @param node The node number.
+     * @return The next sibling node number, or npos for a last child.
+     */
+    size_t next_sibling(size_t node) const {
+        size_t pos = bits.select1(node + 1) + 1;
+        return node != 0 && bits[pos] ? node + 1 : npos;
+    }
+
+    /**
+     * @brief Gets the memory used by the shape, excluding the values.
+     * @return The number of bytes used.
+     */
+    size_t structure_bytes() const { return bits.memory_bytes(); }
+
+    /**
+     * @brief Visits every node in BFS order.
+     * @param visitor Called with each node number.
+     */
+    template <typename Visitor>
+    void for_each_bfs(Visitor visitor) const {
+        for (size_t node = 0; node < size(); ++node) {
+            visitor(node); // BFS order is the numbering order
+        }
+    }
+
+    /**
+     * @brief Visits every node in DFS pre-order without auxiliary storage.
+     * @param visitor Called with each node number.
+     */
+    template <typename Visitor>
+    void for_each_dfs(Visitor visitor) const {
+        size_t node = size() ? 0 : npos;
+        while (node != npos) {
+            visitor(node);
+            size_t next = first_child(node);
+            while (next == npos && node != npos) {
+                next = next_sibling(node); // Climb until a sibling is available
+                if (next == npos) {
+                    node = parent(node);
+                }
+            }
+            node = next;
+        }
+    }
+
+private:
+    BitVector bits;       ///< LOUDS encoding of the shape.
+    std::vector<T> values; ///< Node values in BFS order.
+};
+
+#endif // LOUDS_HPP
@@ -6,6 +6,7 @@
 #include <cstddef>
 #include <iostream>
 #include <stdexcept>
+#include <atomic>
 
 /**
  * @class Node
@@ -22,7 +23,30 @@ public:
      * @brief Constructs a Node with a given value.
      * @param val The value to be stored in the node.
      */
-    explicit Node(const T& val) : value(val), destroyed(false) {}
+    explicit Node(const T& val) : value(val), parent(nullptr), subtree_size(1), destroyed(false) {}
+
+    /**
+     * @brief Copies a node member-wise. The copy shares the original's child pointers
+     *        and starts with its own, unlocked, spinlock.
+     * @param other The node to copy.
+     */
+    Node(const Node& other)
+        : value(other.value), children(other.children), parent(other.parent),
+          subtree_size(other.get_subtree_size()), destroyed(other.destroyed) {}
+
+    /**
+     * @brief Assigns a node member-wise, keeping this node's spinlock.
+     * @param other The node to copy.
+     * @return A reference to this node.
+     */
+    Node& operator=(const Node& other) {
+        value = other.value;
+        children = other.children;
+        parent = other.parent;
+        subtree_size.store(other.get_subtree_size(), std::memory_order_relaxed);
+        destroyed = other.destroyed;
+        return *this;
+    }
 
     /**
      * @brief Gets the value stored in the node.
@@ -30,12 +54,30 @@ public:
      */
     T get_value() const { return value; }
 
+    /**
+     * @brief Sets the value stored in the node.
+     * @param val The new value.
+     */
+    void set_value(const T& val) { value = val; }
+
     /**
      * @brief Gets the children of the node.
      * @return A constant reference to a vector of pointers to the node's children.
      */
     const std::vector<Node*>& get_children() const { return children; }
 
+    /**
+     * @brief Gets the parent of the node.
+     * @return A pointer to the parent node, or nullptr if the node has no parent.
+     */
+    Node* get_parent() const { return parent; }
+
+    /**
+     * @brief Gets the number of nodes in the subtree rooted at this node.
+     * @return The subtree size, including this node.
+     */
+    size_t get_subtree_size() const { return subtree_size.load(std::memory_order_relaxed); }
+
     /**
      * @brief Adds a child to the node.
      * 
@@ -58,12 +100,76 @@ public:
             throw std::runtime_error("Child node type does not match");
         }
         children.push_back(child);
+        child->parent = this;
+        update_subtree_sizes(child->get_subtree_size(), 0);
+    }
+
+    /**
+     * @brief Adds a child while other threads add children elsewhere in the tree, leaving subtree sizes alone.
+     *
+     * The node's child list is guarded by a per-node spinlock, so inserts under different
+     * parents proceed in parallel. Nothing above this node is written, so inserts under different parents share no cache
+     * lines. The caller applies the child's size later with add_to_subtree_sizes, once the
+     * inserting threads are done.
+     *
+     * @param child A pointer to the child node to be added.
+     * @param k The maximum number of children the node can have.
+     * @throws std::runtime_error under the same conditions as add_child.
+     */
+    void link_child_concurrent(Node* child, size_t k) {
+        if (!child) {
+            throw std::runtime_error("Cannot add a null child");
+        }
+        if (typeid(*child) != typeid(Node<T>)) {
+            throw std::runtime_error("Child node type does not match");
+        }
+        while (lock.test_and_set(std::memory_order_acquire)) {
+        }
+        if (children.size() >= k) {
+            lock.clear(std::memory_order_release);
+            throw std::runtime_error("Maximum children exceeded");
+        }
+        children.push_back(child);
+        child->parent = this;
+        lock.clear(std::memory_order_release);
+    }
+
+    /**
+     * @brief Adds to the subtree size of this node and all its ancestors.
+     * @param added The number of nodes linked below this node without updating sizes.
+     */
+    void add_to_subtree_sizes(size_t added) { update_subtree_sizes(added, 0); }
+
+    /**
+     * @brief Appends an empty child slot.
+     *
+     * The slot holds nullptr until set_child fills it, which lets a later child take a
+     * specific position, such as a right child without a left sibling.
+     *
+     * @param k The maximum number of children the node can have.
+     * @throws std::runtime_error if the maximum number of children is exceeded.
+     */
+    void add_empty_slot(size_t k) {
+        if (children.size() >= k) {
+            throw std::runtime_error("Maximum children exceeded");
+        }
+        children.push_back(nullptr);
+    }
+
+    /**
+     * @brief Removes empty slots from the end of the child list.
+     */
+    void trim_empty_slots() {
+        while (!children.empty() && !children.back()) {
+            children.pop_back();
+        }
     }
 
     /**
      * @brief Sets a child at a specific index.
      * 
      * This method replaces the child node at the specified index with a new child node.
+     * The replaced child is unlinked from this node and the new child's parent is updated.
      * 
      * @param index The index at which the child node should be set.
      * @param child A pointer to the new child node.
@@ -73,12 +179,37 @@ public:
         if (index >= children.size()) {
             throw std::out_of_range("Index out of range");
         }
+        size_t removed = 0;
+        if (children[index]) {
+            removed = children[index]->get_subtree_size();
+            if (children[index]->parent == this) {
+                children[index]->parent = nullptr;
+            }
+        }
         children[index] = child;
+        if (child) {
+            child->parent = this;
+        }
+        update_subtree_sizes(child ? child->get_subtree_size() : 0, removed);
     }
 
 private:
+    /**
+     * @brief Applies a change in subtree size to this node and all its ancestors.
+     * @param added The number of nodes added below this node.
+     * @param removed The number of nodes removed from below this node.
+     */
+    void update_subtree_sizes(size_t added, size_t removed) {
+        for (Node* current = this; current != nullptr; current = current->parent) {
+            current->subtree_size.fetch_add(added - removed, std::memory_order_relaxed);
+        }
+    }
+
     T value; ///< The value stored in the node.
     std::vector<Node*> children; ///< Pointers to the children nodes.
+    Node* parent; ///< Pointer to the parent node, nullptr for a root.
+    std::atomic<size_t> subtree_size; ///< Number of nodes in the subtree rooted at this node.
+    std::atomic_flag lock = ATOMIC_FLAG_INIT; ///< Guards the children vector during concurrent inserts.
     bool destroyed; ///< Indicates whether the node is destroyed.
 };
 
@@ -0,0 +1,265 @@
+// Tsadik88@gmail.com
+#ifndef PERSISTENT_TREE_HPP
+#define PERSISTENT_TREE_HPP
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <stdexcept>
+
+/**
+ * @class PersistentTree
+ * @brief An immutable k-ary tree whose updates return new versions.
+ *
+ * Nodes are reference counted and never modified after creation. An update copies
+ * only the nodes on the path from the root to the changed parent and shares every
+ * other subtree with the previous version, so a snapshot is a plain O(1) copy of
+ * the tree and an update costs O(depth * k) time and memory.
+ *
+ * @tparam T The type of the values stored in the tree.
+ */
+template <typename T>
+class PersistentTree {
+public:
+    /**
+     * @class node
+     * @brief An immutable node shared between versions.
+     */
+    class node {
+    public:
+        /**
+         * @brief Constructs a node with a value and children.
+         * @param val The value to be stored in the node.
+         * @param kids The children of the node.
+         */
+        node(const T& val, std::vector<std::shared_ptr<const node>> kids = {})
+            : value(val), children(std::move(kids)), subtree_size(1) {
+            for (const auto& child : children) {
+                if (child) {
+                    subtree_size += child->subtree_size;
+                }
+            }
+        }
+
+        /**
+         * @brief Releases the children without recursion, so deep versions cannot overflow the stack.
+         *
+         * Children owned by this node alone are moved onto an explicit stack and emptied there
+         * before they are destroyed. Shared children only lose a reference.
+         */
+        ~node() {
+            std::vector<std::shared_ptr<const node>> stack;
+            take_unique_children(stack);
+            while (!stack.empty()) {
+                std::shared_ptr<const node> last = std::move(stack.back());
+                stack.pop_back();
+                last->take_unique_children(stack); // last now has no children left to recurse into
+            }
+        }
+
+        /**
+         * @brief Gets the value stored in the node.
+         * @return A constant reference to the value.
+         */
+        const T& get_value() const { return value; }
+
+        /**
+         * @brief Gets the children of the node.
+         * @return A constant reference to the shared child pointers.
+         */
+        const std::vector<std::shared_ptr<const node>>& get_children() const { return children; }
+
+        /**
+         * @brief Gets the number of nodes in the subtree rooted at this node.
+         * @return The subtree size, fixed when the node is created.
+         */
+        size_t get_subtree_size() const { return subtree_size; }
+
+    private:
+        T value; ///< The value stored in the node.
+        /// Children, possibly shared with other versions. Mutable only so destruction can unlink them.
+        mutable std::vector<std::shared_ptr<const node>> children;
+        size_t subtree_size; ///< Number of nodes in this subtree, including this node.
+
+        /**
+         * @brief Moves the children that nothing else references onto a stack and drops the rest.
+         */
+        void take_unique_children(std::vector<std::shared_ptr<const node>>& stack) const {
+            for (auto& child : children) {
+                if (child && child.use_count() == 1) {
+                    stack.push_back(std::move(child));
+                }
+            }
+            children.clear();
+        }
+    };
+
+    /**
+     * @brief Constructs an empty tree.
+     * @param k The maximum number of children per node.
+     */
+    explicit PersistentTree(size_t k = 2) : k(k) {}
+
+    /**
+     * @brief Gets the root node.
+     * @return The root node, or nullptr for an empty tree.
+     */
+    const std::shared_ptr<const node>& get_root() const { return root; }
+
+    /**
+     * @brief Creates a version with a new root and no other nodes.
+     * @param value The value of the root.
+     * @return The new version.
+     */
+    PersistentTree add_root(const T& value) const {
+        PersistentTree result(k);
+        result.root = std::make_shared<const node>(value);
+        return result;
+    }
+
+    /**
+     * @brief Creates a version with a child appended under the node at a path.
+     * @param path Child indices leading from the root to the parent.
+     * @param value The value of the new child.
+     * @return The new version.
+     * @throws std::runtime_error if the root is not set or the parent is full.
+     * @throws std::out_of_range if the path does not exist.
+     */
+    PersistentTree add_sub_node(const std::vector<size_t>& path, const T& value) const {
+        std::vector<const node*> spine = walk(path);
+        const node* parent = spine.back();
+        if (parent->get_children().size() >= k) {
+            throw std::runtime_error("Maximum children exceeded");
+        }
+        std::vector<std::shared_ptr<const node>> children = parent->get_children();
+        children.push_back(std::make_shared<const node>(value));
+        return rebuild(spine, path, std::make_shared<const node>(parent->get_value(), std::move(children)));
+    }
+
+    /**
+     * @brief Creates a version with a child appended under the first node holding a value.
+     *
+     * Finding the parent scans the tree in pre-order, like Tree::add_sub_node; only the
+     * path to the parent is copied. The name differs from the path overload so a braced
+     * path such as {0} never resolves to a value when T is an integer type.
+     *
+     * @param parent_value The value of the parent.
+     * @param value The value of the new child.
+     * @return The new version.
+     * @throws std::runtime_error if the root is not set, the parent is not found or is full.
+     */
+    PersistentTree add_sub_node_under_value(const T& parent_value, const T& value) const {
+        return add_sub_node(find_path(parent_value), value);
+    }
+
+    /**
+     * @brief Creates a version where a child of the node at a path is replaced by a new leaf.
+     * @param path Child indices leading from the root to the parent.
+     * @param index The index of the child to replace.
+     * @param value The value of the new child.
+     * @return The new version.
+     * @throws std::runtime_error if the root is not set.
+     * @throws std::out_of_range if the path or index does not exist.
+     */
+    PersistentTree set_child(const std::vector<size_t>& path, size_t index, const T& value) const {
+        std::vector<const node*> spine = walk(path);
+        const node* parent = spine.back();
+        if (index >= parent->get_children().size()) {
+            throw std::out_of_range("Index out of range");
+        }
+        std::vector<std::shared_ptr<const node>> children = parent->get_children();
+        children[index] = std::make_shared<const node>(value);
+        return rebuild(spine, path, std::make_shared<const node>(parent->get_value(), std::move(children)));
+    }
+
+    /**
+     * @brief Visits every value in pre-order.
+     * @param visitor Called with each value.
+     */
+    template <typename Visitor>
+    void for_each_pre_order(Visitor visitor) const {
+        std::vector<const node*> stack;
+        if (root) {
+            stack.push_back(root.get());
+        }
+        while (!stack.empty()) {
+            const node* current = stack.back();
+            stack.pop_back();
+            visitor(current->get_value());
+            for (auto it = current->get_children().rbegin(); it != current->get_children().rend(); ++it) {
+                stack.push_back(it->get());
+            }
+        }
+    }
+
+private:
+    std::shared_ptr<const node> root; ///< Root of this version.
+    size_t k; ///< Maximum number of children per node.
+
+    /**
+     * @brief Collects the nodes from the root to the end of a path.
+     */
+    std::vector<const node*> walk(const std::vector<size_t>& path) const {
+        if (!root) {
+            throw std::runtime_error("Error: Root not set.");
+        }
+        std::vector<const node*> spine = {root.get()};
+        for (size_t index : path) {
+            const auto& children = spine.back()->get_children();
+            if (index >= children.size()) {
+                throw std::out_of_range("Index out of range");
+            }
+            spine.push_back(children[index].get());
+        }
+        return spine;
+    }
+
+    /**
+     * @brief Copies the spine above a replaced node, sharing every other child.
+     */
+    PersistentTree rebuild(const std::vector<const node*>& spine, const std::vector<size_t>& path,
+                           std::shared_ptr<const node> replacement) const {
+        for (size_t level = path.size(); level > 0; --level) {
+            const node* ancestor = spine[level - 1];
+            std::vector<std::shared_ptr<const node>> children = ancestor->get_children();
+            children[path[level - 1]] = std::move(replacement);
+            replacement = std::make_shared<const node>(ancestor->get_value(), std::move(children));
+        }
+        PersistentTree result(k);
+        result.root = std::move(replacement);
+        return result;
+    }
+
+    /**
+     * @brief Finds the child-index path to the first node holding a value in pre-order.
+     */
+    std::vector<size_t> find_path(const T& value) const {
+        if (!root) {
+            throw std::runtime_error("Error: Root not set.");
+        }
+        std::vector<std::pair<const node*, size_t>> stack = {{root.get(), 0}};
+        if (root->get_value() == value) {
+            return {};
+        }
+        while (!stack.empty()) {
+            const node* current = stack.back().first;
+            size_t next = stack.back().second++;
+            if (next >= current->get_children().size()) {
+                stack.pop_back();
+                continue;
+            }
+            const node* child = current->get_children()[next].get();
+            if (child->get_value() == value) {
+                std::vector<size_t> path;
+                for (const auto& entry : stack) {
+                    path.push_back(entry.second - 1); // Each entry already advanced past the taken child
+                }
+                return path;
+            }
+            stack.emplace_back(child, 0);
+        }
+        throw std::runtime_error("Parent node not found.");
+    }
+};
+
+#endif // PERSISTENT_TREE_HPP
@@ -4,9 +4,19 @@
 #include "node.hpp"
 #include "tree.hpp"
 #include "complex.hpp"
+#include "louds.hpp"
+#include "persistent_tree.hpp"
+#include "avl_tree.hpp"
+#include "veb_layout.hpp"
+#include "eytzinger.hpp"
 #include <string>
 #include <iostream>
 #include <vector>
+#include <deque>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <set>
 
 using namespace std;
 
@@ -66,7 +76,7 @@ TEST_CASE("Testing specific tree structure")
     }
     std::cout << std::endl;
 
-    auto post_order = {8, 2, 6, 7, 1, 9, 3, 4, 5};
+    auto post_order = {6, 1, 7, 9, 2, 3, 4, 5, 8};
     it = post_order.begin();
     std::cout << "Post-order traversal: ";
     for (auto node = tree.begin_post_order(); node != tree.end_post_order(); ++node)
@@ -416,7 +426,7 @@ TEST_CASE("Testing tree with k = 1")
     cout << endl;
     CHECK(expected_pre_order == actual_pre_order);
 
-    vector<int> expected_post_order = {1, 2, 3, 4};
+    vector<int> expected_post_order = {4, 3, 2, 1};
     vector<int> actual_post_order;
     cout << "Post-order traversal: ";
     for (auto node = tree.begin_post_order(); node != tree.end_post_order(); ++node)
@@ -586,7 +596,7 @@ TEST_CASE("Testing 5-ary tree with doubles that are not sorted")
     cout << endl;
     CHECK(expected_pre_order == actual_pre_order);
 
-    vector<double> expected_post_order = {1.1, 1.2, 1.3, 1.8, 1.7, 12.11, 25.36, 1.5, 1.6};
+    vector<double> expected_post_order = {1.2, 1.3, 12.11, 1.7, 25.36, 1.8, 1.5, 1.6, 1.1};
     vector<double> actual_post_order;
     cout << "Post-order traversal: ";
     for (auto node = tree.begin_post_order(); node != tree.end_post_order(); ++node)
@@ -608,3 +618,1555 @@ TEST_CASE("Testing 5-ary tree with doubles that are not sorted")
     cout << endl;
     CHECK(expected_in_order == actual_in_order);
 }
+
+TEST_CASE("Testing parent links and ancestor queries")
+{
+    Node<int> root(1);
+    Tree<int> tree(3);
+    tree.add_root(root);
+
+    Node<int> n1(2);
+    Node<int> n2(3);
+    Node<int> n3(4);
+    Node<int> n4(5);
+
+    tree.add_sub_node(root, n1);
+    tree.add_sub_node(root, n2);
+    tree.add_sub_node(n1, n3);
+    tree.add_sub_node(n3, n4);
+
+    CHECK(root.get_parent() == nullptr);
+    CHECK(n4.get_parent() == &n3);
+    CHECK(tree.depth(root) == 0);
+    CHECK(tree.depth(n4) == 3);
+
+    vector<Node<int> *> expected_path = {&n4, &n3, &n1, &root};
+    CHECK(tree.path_to_root(n4) == expected_path);
+
+    CHECK(tree.is_ancestor(root, n4));
+    CHECK(tree.is_ancestor(n1, n3));
+    CHECK(tree.is_ancestor(n3, n3));
+    CHECK_FALSE(tree.is_ancestor(n2, n4));
+    CHECK_FALSE(tree.is_ancestor(n4, n1));
+
+    Node<int> n5(6);
+    n1.set_child(0, &n5);
+    CHECK(n3.get_parent() == nullptr);
+    CHECK(n5.get_parent() == &n1);
+    CHECK(tree.depth(n5) == 2);
+}
+
+TEST_CASE("Testing LCA index")
+{
+    Node<int> root(1);
+    Tree<int> tree(3);
+    tree.add_root(root);
+
+    Node<int> n1(2);
+    Node<int> n2(3);
+    Node<int> n3(4);
+    Node<int> n4(5);
+    Node<int> n5(6);
+    Node<int> n6(7);
+
+    tree.add_sub_node(root, n1);
+    tree.add_sub_node(root, n2);
+    tree.add_sub_node(n1, n3);
+    tree.add_sub_node(n1, n4);
+    tree.add_sub_node(n4, n5);
+    tree.add_sub_node(n2, n6);
+
+    CHECK_THROWS_WITH(tree.lca(n3, n4), "LCA index is not built.");
+
+    tree.build_lca_index();
+    CHECK(tree.lca(n3, n5) == &n1);
+    CHECK(tree.lca(n5, n6) == &root);
+    CHECK(tree.lca(n4, n5) == &n4);
+    CHECK(tree.lca(n3, n3) == &n3);
+    CHECK(tree.is_ancestor(n1, n5));
+    CHECK_FALSE(tree.is_ancestor(n2, n5));
+
+    Node<int> n7(8);
+    tree.add_sub_node(n6, n7);
+    CHECK_THROWS_WITH(tree.lca(n7, n5), "LCA index is not built.");
+    CHECK(tree.is_ancestor(n2, n7));
+
+    tree.build_lca_index();
+    CHECK(tree.lca(n7, n5) == &root);
+
+    Node<int> n8(9);
+    tree.set_child(n1, 1, &n8);
+    CHECK_THROWS_WITH(tree.lca(n8, n3), "LCA index is not built.");
+    tree.build_lca_index();
+    CHECK(tree.lca(n8, n3) == &n1);
+    CHECK_THROWS_WITH(tree.lca(n5, n3), "Node not found in LCA index.");
+}
+
+TEST_CASE("Testing subtree sizes and aggregates")
+{
+    Node<int> root(10);
+    Tree<int> tree(3);
+    tree.add_root(root);
+
+    Node<int> n1(4);
+    Node<int> n2(7);
+    Node<int> n3(1);
+    Node<int> n4(12);
+
+    tree.add_sub_node(root, n1);
+    tree.add_sub_node(root, n2);
+    tree.add_sub_node(n1, n3);
+
+    CHECK_THROWS_WITH(tree.subtree_aggregate(root), "Aggregate not set.");
+
+    tree.set_aggregate(sum_op<int>());
+    CHECK(tree.subtree_aggregate(root) == 22);
+    CHECK(tree.subtree_aggregate(n1) == 5);
+
+    tree.add_sub_node(n3, n4);
+    CHECK(tree.subtree_size(root) == 5);
+    CHECK(tree.subtree_size(n1) == 3);
+    CHECK(tree.subtree_size(n2) == 1);
+    CHECK(tree.subtree_aggregate(root) == 34);
+    CHECK(tree.subtree_aggregate(n1) == 17);
+    CHECK(tree.subtree_aggregate(n3) == 13);
+
+    tree.set_aggregate(max_op<int>());
+    CHECK(tree.subtree_aggregate(root) == 12);
+    CHECK(tree.subtree_aggregate(n2) == 7);
+
+    Node<int> n5(2);
+    tree.set_child(n1, 0, &n5);
+    CHECK(tree.subtree_size(root) == 4);
+    CHECK(tree.subtree_size(n1) == 2);
+    CHECK(tree.subtree_aggregate(root) == 10);
+    CHECK(tree.subtree_aggregate(n1) == 4);
+    CHECK_THROWS_WITH(tree.subtree_aggregate(n3), "Node not found in aggregate cache.");
+    CHECK_THROWS_WITH(tree.subtree_aggregate(n4), "Node not found in aggregate cache.");
+
+    tree.set_aggregate(min_op<int>());
+    CHECK(tree.subtree_aggregate(root) == 2);
+}
+
+TEST_CASE("Testing heavy-light path queries")
+{
+    Node<int> root(5);
+    Tree<int> tree(3);
+    tree.add_root(root);
+
+    Node<int> n1(3);
+    Node<int> n2(8);
+    Node<int> n3(1);
+    Node<int> n4(9);
+    Node<int> n5(2);
+    Node<int> n6(7);
+    Node<int> n7(4);
+
+    tree.add_sub_node(root, n1);
+    tree.add_sub_node(root, n2);
+    tree.add_sub_node(n1, n3);
+    tree.add_sub_node(n1, n4);
+    tree.add_sub_node(n4, n5);
+    tree.add_sub_node(n2, n6);
+    tree.add_sub_node(n6, n7);
+
+    auto sums = tree.build_path_index(sum_op<int>());
+    CHECK(sums.path_query(n5, n7) == 2 + 9 + 3 + 5 + 8 + 7 + 4);
+    CHECK(sums.path_query(n3, n5) == 1 + 3 + 9 + 2);
+    CHECK(sums.path_query(n4, n4) == 9);
+    CHECK(sums.path_query(root, n7) == 5 + 8 + 7 + 4);
+
+    auto maxima = tree.build_path_index(max_op<int>());
+    CHECK(maxima.path_query(n3, n7) == 8);
+    CHECK(maxima.path_query(n3, n5) == 9);
+
+    tree.set_aggregate(sum_op<int>());
+    maxima.update(n4, 0);
+    CHECK(n4.get_value() == 0);
+    CHECK(maxima.path_query(n3, n5) == 3);
+    CHECK(maxima.path_query(n5, n7) == 8);
+
+    // Updates go through the tree, so aggregates and other indexes see them
+    CHECK(tree.subtree_aggregate(n1) == 3 + 1 + 0 + 2);
+    CHECK(sums.path_query(n3, n5) == 1 + 3 + 0 + 2);
+    sums.update(n5, 100);
+    CHECK(tree.subtree_aggregate(n4) == 100);
+    CHECK(tree.subtree_aggregate(root) == 5 + 3 + 1 + 100 + 8 + 7 + 4);
+    CHECK(maxima.path_query(n3, n5) == 100);
+    tree.set_value(n7, 50);
+    CHECK(sums.path_query(root, n7) == 5 + 8 + 7 + 50);
+    CHECK(maxima.path_query(n5, n7) == 100);
+
+    Node<int> outsider(42);
+    CHECK_THROWS_WITH(sums.path_query(outsider, root), "Node not found in path index.");
+    CHECK_THROWS_WITH(tree.set_value(outsider, 1), "Node not found in tree.");
+
+    // Structural changes leave built indexes out of date, as with the LCA index
+    Node<int> n8(6);
+    tree.add_sub_node(n7, n8);
+    CHECK_THROWS_WITH(sums.path_query(root, n7), "Path index is out of date.");
+    CHECK_THROWS_WITH(maxima.update(n7, 1), "Path index is out of date.");
+    CHECK(n7.get_value() == 50);
+    auto rebuilt = tree.build_path_index(sum_op<int>());
+    CHECK(rebuilt.path_query(root, n8) == 5 + 8 + 7 + 50 + 6);
+}
+
+TEST_CASE("Testing LOUDS encoding")
+{
+    Node<int> root(1);
+    Tree<int> tree(3);
+    tree.add_root(root);
+
+    Node<int> n1(2);
+    Node<int> n2(3);
+    Node<int> n3(4);
+    Node<int> n4(5);
+    Node<int> n5(6);
+    Node<int> n6(7);
+
+    tree.add_sub_node(root, n1);
+    tree.add_sub_node(root, n2);
+    tree.add_sub_node(root, n3);
+    tree.add_sub_node(n1, n4);
+    tree.add_sub_node(n1, n5);
+    tree.add_sub_node(n3, n6);
+
+    LoudsTree<int> louds(tree);
+    CHECK(louds.size() == 7);
+    CHECK(louds.value(0) == 1);
+    CHECK(louds.child_count(0) == 3);
+    CHECK(louds.child_count(1) == 2);
+    CHECK(louds.child_count(2) == 0);
+    CHECK(louds.value(louds.child(0, 2)) == 4);
+    CHECK(louds.value(louds.child(1, 1)) == 6);
+    CHECK(louds.value(louds.first_child(3)) == 7);
+    CHECK(louds.first_child(2) == LoudsTree<int>::npos);
+    CHECK(louds.parent(0) == LoudsTree<int>::npos);
+    CHECK(louds.value(louds.parent(louds.child(3, 0))) == 4);
+    CHECK(louds.next_sibling(1) == 2);
+    CHECK(louds.next_sibling(3) == LoudsTree<int>::npos);
+    CHECK_THROWS_AS(louds.child(2, 0), std::out_of_range);
+
+    vector<int> expected_bfs;
+    for (auto node = tree.begin_bfs_scan(); node != tree.end_bfs_scan(); ++node)
+        expected_bfs.push_back(node->get_value());
+    vector<int> actual_bfs;
+    louds.for_each_bfs([&](size_t node) { actual_bfs.push_back(louds.value(node)); });
+    CHECK(expected_bfs == actual_bfs);
+
+    vector<int> expected_dfs;
+    for (auto node = tree.begin_dfs_scan(); node != tree.end_dfs_scan(); ++node)
+        expected_dfs.push_back(node->get_value());
+    vector<int> actual_dfs;
+    louds.for_each_dfs([&](size_t node) { actual_dfs.push_back(louds.value(node)); });
+    CHECK(expected_dfs == actual_dfs);
+}
+
+TEST_CASE("Testing concurrent readers with published snapshots")
+{
+    std::deque<Node<int>> nodes;
+    nodes.emplace_back(0);
+    Tree<int> tree(4);
+    tree.add_root(nodes.front());
+    tree.publish();
+
+    const int total = 2000;
+    std::atomic<bool> done(false);
+    std::atomic<int> failures(0);
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 4; ++r)
+    {
+        readers.emplace_back([&]()
+                             {
+            size_t last_size = 0;
+            while (!done.load())
+            {
+                auto version = tree.current_snapshot();
+                if (version.size() < last_size)
+                    failures++;
+                last_size = version.size();
+                size_t counted = 1;
+                std::vector<const Tree<int>::published_node *> pending = {version.get_root()};
+                while (!pending.empty())
+                {
+                    const Tree<int>::published_node *node = pending.back();
+                    pending.pop_back();
+                    size_t below = 1;
+                    for (const auto &child : node->get_children())
+                    {
+                        if (child->get_value() <= node->get_value())
+                            failures++;
+                        below += child->get_subtree_size();
+                        counted++;
+                        pending.push_back(child.get());
+                    }
+                    if (below != node->get_subtree_size())
+                        failures++;
+                }
+                if (counted != version.size())
+                    failures++;
+            } });
+    }
+
+    for (int i = 1; i < total; ++i)
+    {
+        nodes.emplace_back(i);
+        tree.add_sub_node(nodes[(i - 1) / 4], nodes.back()); // Children always have larger values
+        if (i % 50 == 0)
+            tree.publish();
+    }
+    tree.publish();
+    done = true;
+    for (auto &reader : readers)
+        reader.join();
+
+    CHECK(failures.load() == 0);
+    CHECK(tree.current_snapshot().size() == total);
+
+    // A new version copies only the changed path and shares every other subtree with the last one
+    auto before = tree.current_snapshot();
+    tree.set_value(nodes[5], 5000);
+    tree.publish();
+    auto after = tree.current_snapshot();
+    const auto &old_top = before.get_root()->get_children();
+    const auto &new_top = after.get_root()->get_children();
+    CHECK(new_top[0] != old_top[0]); // nodes[5] lies under nodes[1]
+    CHECK(new_top[1] == old_top[1]);
+    CHECK(new_top[0]->get_children()[0]->get_value() == 5000);
+    CHECK(old_top[0]->get_children()[0]->get_value() == 5);
+    CHECK(after.get_root() != before.get_root());
+
+    tree.move_subtree(nodes[3], nodes[597], 0); // nodes[597] is a leaf below nodes[2], via 9, 37 and 149
+    Node<int> *removed = tree.detach(nodes[4]);
+    tree.publish();
+    auto restructured = tree.current_snapshot();
+    const auto &top = restructured.get_root()->get_children();
+    CHECK(restructured.size() == total - removed->get_subtree_size());
+    CHECK(top.size() == 2); // nodes[3] and nodes[4] left the root
+    const Tree<int>::published_node *leaf = top[1].get();
+    for (int level = 0; level < 4; ++level)
+        leaf = leaf->get_children()[0].get();
+    CHECK(leaf->get_value() == 597);
+    CHECK(leaf->get_children()[0] == old_top[2]); // The moved subtree keeps its published copy
+    CHECK(top[0] == new_top[0]);
+
+    tree.publish(); // Nothing changed, so the new version shares the whole tree
+    CHECK(tree.current_snapshot().get_root() == restructured.get_root());
+
+    Tree<int> copy(tree);
+    CHECK(copy.current_snapshot().get_root() == restructured.get_root());
+    Tree<int> empty;
+    CHECK(empty.current_snapshot().get_root() == nullptr);
+    CHECK(empty.current_snapshot().size() == 0);
+}
+
+TEST_CASE("Testing concurrent insertion under disjoint parents")
+{
+    const int threads = 8;
+    const int per_thread = 500;
+    for (bool with_aggregate : {false, true})
+    {
+        Node<int> root(0);
+        Tree<int> tree(threads);
+        tree.add_root(root);
+        if (with_aggregate)
+        {
+            tree.set_aggregate(sum_op<int>());
+            tree.enable_hashing();
+        }
+
+        std::vector<std::deque<Node<int>>> nodes(threads);
+        for (int t = 0; t < threads; ++t)
+        {
+            nodes[t].emplace_back(1);
+            tree.add_sub_node_concurrent(root, nodes[t].front());
+        }
+
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&, t]()
+                                 {
+                for (int i = 1; i < per_thread; ++i)
+                {
+                    nodes[t].emplace_back(1);
+                    tree.add_sub_node_concurrent(nodes[t][(i - 1) / 2], nodes[t].back());
+                } });
+        }
+        for (auto &worker : workers)
+            worker.join();
+
+        // Sizes and caches are folded in once the threads are done
+        tree.sync();
+        CHECK(root.get_subtree_size() == threads * per_thread + 1);
+        CHECK(tree.subtree_size(root) == threads * per_thread + 1);
+        for (int t = 0; t < threads; ++t)
+        {
+            CHECK(tree.subtree_size(nodes[t].front()) == per_thread);
+            CHECK(tree.subtree_size(nodes[t][1]) == 255);
+            CHECK(nodes[t].back().get_parent() == &nodes[t][(per_thread - 2) / 2]);
+        }
+        if (with_aggregate)
+        {
+            CHECK(tree.subtree_aggregate(root) == threads * per_thread);
+            CHECK(tree.subtree_aggregate(nodes[threads - 1][2]) == 244);
+            for (int t = 1; t < threads; ++t)
+                CHECK(tree.subtree_hash(nodes[t].front()) == tree.subtree_hash(nodes[0].front()));
+            CHECK(tree.subtree_hash(nodes[0][1]) != tree.subtree_hash(nodes[0][2]));
+        }
+
+        Node<int> extra(1);
+        CHECK_THROWS_WITH(tree.add_sub_node_concurrent(root, extra), "Maximum children exceeded");
+        Node<int> stray(1);
+        CHECK_THROWS_WITH(tree.add_sub_node_concurrent(stray, extra), "Parent node not found.");
+        CHECK(stray.get_children().empty());
+        CHECK(extra.get_parent() == nullptr);
+    }
+}
+
+TEST_CASE("Testing persistent tree versions")
+{
+    PersistentTree<int> empty(3);
+    CHECK_THROWS_WITH(empty.add_sub_node(vector<size_t>{}, 1), "Error: Root not set.");
+
+    PersistentTree<int> v1 = empty.add_root(1);
+    PersistentTree<int> v2 = v1.add_sub_node(vector<size_t>{}, 2);
+    PersistentTree<int> v3 = v2.add_sub_node(vector<size_t>{}, 3);
+    PersistentTree<int> v4 = v3.add_sub_node_under_value(2, 4);
+    PersistentTree<int> v5 = v4.set_child(vector<size_t>{0}, 0, 5);
+
+    auto values = [](const PersistentTree<int> &tree)
+    {
+        vector<int> result;
+        tree.for_each_pre_order([&](int value) { result.push_back(value); });
+        return result;
+    };
+    CHECK(values(v1) == vector<int>{1});
+    CHECK(values(v3) == vector<int>{1, 2, 3});
+    CHECK(values(v4) == vector<int>{1, 2, 4, 3});
+    CHECK(values(v5) == vector<int>{1, 2, 5, 3});
+
+    // Untouched subtrees are shared, the updated spine is copied
+    CHECK(v4.get_root()->get_children()[1] == v3.get_root()->get_children()[1]);
+    CHECK(v5.get_root()->get_children()[1] == v4.get_root()->get_children()[1]);
+    CHECK(v5.get_root()->get_children()[0] != v4.get_root()->get_children()[0]);
+
+    PersistentTree<int> snapshot = v5;
+    CHECK(snapshot.get_root() == v5.get_root());
+
+    CHECK_THROWS_AS(v5.set_child(vector<size_t>{1}, 0, 6), std::out_of_range);
+    CHECK_THROWS_WITH(v5.add_sub_node_under_value(42, 6), "Parent node not found.");
+    PersistentTree<int> full = v5.add_sub_node_under_value(1, 6);
+    CHECK_THROWS_WITH(full.add_sub_node_under_value(1, 7), "Maximum children exceeded");
+
+    // With integer values a braced path must still address the parent by position
+    PersistentTree<size_t> indexed = PersistentTree<size_t>(2).add_root(7).add_sub_node({}, 5);
+    PersistentTree<size_t> nested = indexed.add_sub_node({0}, 1);
+    CHECK(nested.get_root()->get_children()[0]->get_children()[0]->get_value() == 1);
+    CHECK_THROWS_WITH(indexed.add_sub_node_under_value(0, 1), "Parent node not found.");
+
+    // Releasing a deep chain must not recurse once per level
+    using persistent_node = PersistentTree<int>::node;
+    std::shared_ptr<const persistent_node> chain;
+    for (int i = 0; i < 1000000; ++i)
+        chain = std::make_shared<const persistent_node>(i, vector<std::shared_ptr<const persistent_node>>{chain});
+    auto first = std::make_shared<const persistent_node>(-1, vector<std::shared_ptr<const persistent_node>>{chain});
+    auto second = std::make_shared<const persistent_node>(-2, vector<std::shared_ptr<const persistent_node>>{chain});
+    chain.reset();
+    first.reset(); // The chain is shared with second, so it must survive
+    size_t length = 0;
+    for (const persistent_node *current = second->get_children()[0].get(); current; ++length)
+        current = current->get_children()[0].get();
+    CHECK(length == 1000000);
+    second.reset();
+}
+
+TEST_CASE("Testing vectorized Complex comparisons and top-k")
+{
+    vector<Complex> values = {Complex(3, 1), Complex(1, 5), Complex(3, 0), Complex(2, 2), Complex(1, 4),
+                              Complex(7, 7), Complex(3, 1), Complex(0, 9), Complex(5, 5)};
+    ComplexBatch batch(values);
+    vector<uint8_t> mask(values.size());
+    CHECK(batch.less_than(Complex(3, 1), mask.data()) == 5);
+    for (size_t i = 0; i < values.size(); ++i)
+        CHECK(bool(mask[i]) == (values[i] < Complex(3, 1)));
+    CHECK(batch.greater_than(Complex(3, 1), mask.data()) == 2);
+
+    vector<Complex> sorted = values;
+    std::sort(sorted.begin(), sorted.end());
+    vector<size_t> order = batch.sorted_order();
+    for (size_t i = 0; i < values.size(); ++i)
+        CHECK(values[order[i]] == sorted[i]);
+
+    vector<size_t> smallest = batch.smallest(4);
+    REQUIRE(smallest.size() == 4);
+    for (size_t i = 0; i < smallest.size(); ++i)
+        CHECK(values[smallest[i]] == sorted[i]);
+
+    Node<Complex> root(Complex(5.5, 6.6));
+    Tree<Complex> tree;
+    tree.add_root(root);
+    Node<Complex> n1(Complex(3.3, 4.4));
+    Node<Complex> n2(Complex(7.7, 8.8));
+    Node<Complex> n3(Complex(1.1, 2.2));
+    tree.add_sub_node(root, n1);
+    tree.add_sub_node(root, n2);
+    tree.add_sub_node(n1, n3);
+
+    vector<Complex> expected_top = {Complex(1.1, 2.2), Complex(3.3, 4.4)};
+    CHECK(tree.top_k(2) == expected_top);
+    CHECK(tree.top_k(10).size() == 4);
+
+    Node<int> int_root(4);
+    Tree<int> int_tree;
+    int_tree.add_root(int_root);
+    Node<int> i1(9);
+    Node<int> i2(1);
+    int_tree.add_sub_node(int_root, i1);
+    int_tree.add_sub_node(int_root, i2);
+    CHECK(int_tree.top_k(2) == vector<int>{1, 4});
+}
+
+TEST_CASE("Testing vectorized Complex ordering past the insertion sort cutoff")
+{
+    std::mt19937 random(7);
+    std::uniform_int_distribution<int> part(-4, 4); // A small range gives many duplicates and equal real parts
+    for (size_t size : {17, 33, 100, 1000, 4099})
+    {
+        vector<Complex> values;
+        for (size_t i = 0; i < size; ++i)
+            values.emplace_back(part(random), part(random));
+        // Equal magnitudes in different orders, and zeros of both signs
+        for (Complex c : {Complex(3, 4), Complex(4, 3), Complex(-5, 0), Complex(0, -5), Complex(-3, 4), Complex(0.0, -0.0), Complex(-0.0, 0.0)})
+            values[random() % size] = c;
+        ComplexBatch batch(values);
+
+        vector<uint8_t> mask(size);
+        for (Complex pivot : {values[0], values[size / 2], Complex(0, 0), Complex(3, 4)})
+        {
+            size_t below = batch.less_than(pivot, mask.data());
+            CHECK(below == size_t(std::count_if(values.begin(), values.end(), [&](const Complex &c) { return c < pivot; })));
+            for (size_t i = 0; i < size; ++i)
+                CHECK(bool(mask[i]) == (values[i] < pivot));
+            size_t above = batch.greater_than(pivot, mask.data());
+            CHECK(above == size_t(std::count_if(values.begin(), values.end(), [&](const Complex &c) { return c > pivot; })));
+            for (size_t i = 0; i < size; ++i)
+                CHECK(bool(mask[i]) == (values[i] > pivot));
+        }
+
+        vector<Complex> sorted = values;
+        std::sort(sorted.begin(), sorted.end());
+        vector<size_t> order = batch.sorted_order();
+        REQUIRE(order.size() == size);
+        vector<size_t> seen = order;
+        std::sort(seen.begin(), seen.end());
+        for (size_t i = 0; i < size; ++i)
+        {
+            CHECK(seen[i] == i); // A permutation of every position
+            CHECK(values[order[i]] == sorted[i]);
+        }
+
+        for (size_t count : {size_t(0), size_t(1), size_t(16), size_t(17), size / 2, size - 1, size, size + 5})
+        {
+            vector<Complex> partial = values;
+            size_t expected = std::min(count, size);
+            std::partial_sort(partial.begin(), partial.begin() + expected, partial.end());
+            vector<size_t> smallest = batch.smallest(count);
+            REQUIRE(smallest.size() == expected);
+            std::set<size_t> distinct(smallest.begin(), smallest.end());
+            CHECK(distinct.size() == expected);
+            for (size_t i = 0; i < expected; ++i)
+                CHECK(values[smallest[i]] == partial[i]);
+        }
+    }
+
+    // Every value equal is the worst case for the pivot runs
+    vector<Complex> equal(257, Complex(1, 1));
+    ComplexBatch same(equal);
+    CHECK(same.sorted_order().size() == 257);
+    CHECK(same.smallest(100).size() == 100);
+    vector<uint8_t> mask(equal.size());
+    CHECK(same.less_than(Complex(1, 1), mask.data()) == 0);
+    CHECK(same.greater_than(Complex(1, 0), mask.data()) == 257);
+}
+
+TEST_CASE("Testing Complex arithmetic and batch operations")
+{
+    Complex a(3, 4);
+    Complex b(1, -2);
+    CHECK(a + b == Complex(4, 2));
+    CHECK(a - b == Complex(2, 6));
+    CHECK(a * b == Complex(11, -2));
+    CHECK((a * b) / b == a);
+    CHECK(-a == Complex(-3, -4));
+    CHECK(a.abs() == 5);
+    CHECK(a.norm() == 25);
+    CHECK(a.conjugate() == Complex(3, -4));
+    CHECK(std::hash<Complex>()(Complex(0.0, 1)) == std::hash<Complex>()(Complex(-0.0, 1)));
+
+    vector<Complex> values = {Complex(1, 2), Complex(3, 4), Complex(-5, 0), Complex(0, -12), Complex(6, 8)};
+    CHECK(ComplexBatch::sum(values.data(), values.size()) == Complex(5, 2));
+    CHECK(ComplexBatch::dot(values.data(), values.data(), 2) == Complex(1, 2) * Complex(1, 2) + Complex(3, 4) * Complex(3, 4));
+    vector<double> magnitudes(values.size());
+    ComplexBatch::magnitude(values.data(), values.size(), magnitudes.data());
+    CHECK(magnitudes[1] == 5);
+    CHECK(magnitudes[2] == 5);
+    CHECK(magnitudes[3] == 12);
+    CHECK(magnitudes[4] == 10);
+
+    Node<Complex> root(Complex(1, 1));
+    Tree<Complex> tree;
+    tree.add_root(root);
+    Node<Complex> n1(Complex(2, -1));
+    Node<Complex> n2(Complex(0.5, 3));
+    tree.add_sub_node(root, n1);
+    tree.add_sub_node(root, n2);
+    tree.set_aggregate(sum_op<Complex>());
+    CHECK(tree.subtree_aggregate(root) == Complex(3.5, 3));
+}
+
+TEST_CASE("Testing Complex formatting and parsing")
+{
+    char buffer[64];
+    Complex value(0.1, -2.5e-7);
+    auto written = to_chars(buffer, buffer + sizeof(buffer), value);
+    REQUIRE(written.ec == std::errc());
+    CHECK(std::string(buffer, written.ptr) == "0.1+-2.5e-07i");
+
+    Complex parsed;
+    auto read = from_chars(buffer, written.ptr, parsed);
+    CHECK(read.ec == std::errc());
+    CHECK(read.ptr == written.ptr);
+    CHECK(parsed == value);
+
+    Complex precise(1.0 / 3.0, 2);
+    written = to_chars(buffer, buffer + sizeof(buffer), precise, std::chars_format::general, 6);
+    std::ostringstream stream;
+    stream << precise;
+    CHECK(std::string(buffer, written.ptr) == stream.str());
+
+    std::string text = "3-4i";
+    CHECK(from_chars(text.data(), text.data() + text.size(), parsed).ec == std::errc());
+    CHECK(parsed == Complex(3, -4));
+    text = "3+4";
+    CHECK(from_chars(text.data(), text.data() + text.size(), parsed).ec == std::errc::invalid_argument);
+    CHECK(to_chars(buffer, buffer + 3, precise).ec == std::errc::value_too_large);
+}
+
+TEST_CASE("Testing traversal ranges with standard algorithms")
+{
+    Node<int> root(1);
+    Tree<int> tree;
+    tree.add_root(root);
+    Node<int> n1(2);
+    Node<int> n2(3);
+    Node<int> n3(4);
+    Node<int> n4(5);
+    tree.add_sub_node(root, n1);
+    tree.add_sub_node(root, n2);
+    tree.add_sub_node(n1, n3);
+    tree.add_sub_node(n1, n4);
+
+    vector<int> pre_order;
+    for (const Node<int> &node : tree.pre_order())
+        pre_order.push_back(node.get_value());
+    CHECK(pre_order == vector<int>{1, 2, 4, 5, 3});
+
+    auto bfs = tree.bfs();
+    CHECK(std::distance(bfs.begin(), bfs.end()) == 5);
+    CHECK(std::count_if(bfs.begin(), bfs.end(), [](const Node<int> &node)
+                        { return node.get_value() % 2 == 0; }) == 2);
+
+    auto post_order = tree.post_order();
+    auto found = std::find_if(post_order.begin(), post_order.end(), [](const Node<int> &node)
+                              { return node.get_value() == 2; });
+    REQUIRE(found != post_order.end());
+    CHECK(&*found == &n1);
+
+    auto it = tree.begin_dfs_scan();
+    auto previous = it++;
+    CHECK(previous->get_value() == 1);
+    CHECK(it->get_value() == 2);
+    CHECK(tree.end_dfs_scan() == Tree<int>::dfs_iterator());
+
+    vector<int> heap_values;
+    std::transform(tree.heap().begin(), tree.heap().end(), std::back_inserter(heap_values), [](const Node<int> &node)
+                   { return node.get_value(); });
+    CHECK(heap_values == vector<int>{1, 2, 3, 4, 5});
+
+    static_assert(std::is_same<std::iterator_traits<Tree<int>::in_order_iterator>::iterator_category,
+                               std::forward_iterator_tag>::value,
+                  "traversal iterators are forward iterators");
+}
+
+TEST_CASE("Testing iterator positions, sub-ranges and chunks")
+{
+    Node<int> root(1);
+    Tree<int> tree(3);
+    tree.add_root(root);
+    Node<int> n1(2);
+    Node<int> n2(3);
+    Node<int> n3(4);
+    Node<int> n4(5);
+    Node<int> n5(6);
+    Node<int> n6(7);
+    tree.add_sub_node(root, n1);
+    tree.add_sub_node(root, n2);
+    tree.add_sub_node(root, n3);
+    tree.add_sub_node(n1, n4);
+    tree.add_sub_node(n1, n5);
+    tree.add_sub_node(n3, n6);
+
+    auto first = tree.begin_pre_order();
+    auto second = std::next(first);
+    CHECK(first != second);
+    CHECK(std::next(first, 1) == second);
+    CHECK(std::next(first, 7) == tree.end_pre_order());
+
+    auto from = std::next(tree.begin_bfs_scan(), 1);
+    auto to = std::next(tree.begin_bfs_scan(), 4);
+    vector<int> middle;
+    for (auto it = from; it != to; ++it)
+        middle.push_back(it->get_value());
+    CHECK(middle == vector<int>{2, 3, 4});
+
+    auto post_first = tree.begin_post_order();
+    CHECK(std::distance(post_first, std::next(post_first, 3)) == 3);
+
+    auto chunks = tree.pre_order().chunks(3);
+    REQUIRE(chunks.size() == 3);
+    vector<int> chunked;
+    vector<size_t> chunk_sizes;
+    for (const auto &chunk : chunks)
+    {
+        chunk_sizes.push_back(std::distance(chunk.begin(), chunk.end()));
+        for (const Node<int> &node : chunk)
+            chunked.push_back(node.get_value());
+    }
+    CHECK(chunk_sizes == vector<size_t>{3, 3, 1});
+    CHECK(chunked == vector<int>{1, 2, 5, 6, 3, 4, 7});
+    CHECK_THROWS_AS(tree.pre_order().chunks(0), std::invalid_argument);
+
+    Tree<int> binary;
+    Node<int> b_root(4);
+    Node<int> b1(9);
+    Node<int> b2(1);
+    binary.add_root(b_root);
+    binary.add_sub_node(b_root, b1);
+    binary.add_sub_node(b_root, b2);
+    auto heap_first = binary.heap().begin();
+    CHECK(std::next(heap_first, 1) != std::next(heap_first, 2));
+    CHECK(std::next(heap_first, 1)->get_value() == 4);
+    CHECK(std::next(heap_first, 3) == binary.end_heap());
+}
+
+TEST_CASE("Testing resumable walks")
+{
+    Node<int> root(1);
+    Tree<int> tree;
+    tree.add_root(root);
+    Node<int> n1(2);
+    Node<int> n2(3);
+    Node<int> n3(4);
+    Node<int> n4(5);
+    tree.add_sub_node(root, n1);
+    tree.add_sub_node(root, n2);
+    tree.add_sub_node(n1, n3);
+    tree.add_sub_node(n1, n4);
+
+    auto walk = tree.walk(Tree<int>::walk_order::post_order);
+    vector<int> values;
+    auto collect = [&](const Node<int> &node)
+    { values.push_back(node.get_value()); };
+    CHECK(walk.resume(2, collect) == 2);
+    CHECK(values == vector<int>{4, 5});
+    CHECK_FALSE(walk.done());
+
+    // Another walk can run while the first is suspended
+    auto bfs = tree.walk(Tree<int>::walk_order::bfs);
+    CHECK(bfs.next() == &root);
+    CHECK(bfs.next() == &n1);
+
+    CHECK(walk.resume(10, collect) == 3);
+    CHECK(values == vector<int>{4, 5, 2, 3, 1});
+    CHECK(walk.done());
+    CHECK(walk.next() == nullptr);
+    CHECK(walk.resume(10, collect) == 0);
+
+    auto in_order = tree.walk(Tree<int>::walk_order::in_order);
+    vector<int> in_order_values;
+    while (Node<int> *node = in_order.next())
+        in_order_values.push_back(node->get_value());
+    CHECK(in_order_values == vector<int>{4, 2, 5, 1, 3});
+}
+
+TEST_CASE("Testing pruned visits")
+{
+    // Binary search tree shape, so a value range prunes whole subtrees
+    Node<int> root(50);
+    Tree<int> tree;
+    tree.add_root(root);
+    Node<int> n1(25);
+    Node<int> n2(75);
+    Node<int> n3(10);
+    Node<int> n4(30);
+    Node<int> n5(60);
+    Node<int> n6(90);
+    tree.add_sub_node(root, n1);
+    tree.add_sub_node(root, n2);
+    tree.add_sub_node(n1, n3);
+    tree.add_sub_node(n1, n4);
+    tree.add_sub_node(n2, n5);
+    tree.add_sub_node(n2, n6);
+
+    vector<int> checked;
+    vector<int> visited;
+    bool finished = tree.visit([&](const Node<int> &node)
+                               { checked.push_back(node.get_value());
+                                 return node.get_value() >= 50; },
+                               [&](Node<int> &node)
+                               { visited.push_back(node.get_value());
+                                 return true; });
+    CHECK(finished);
+    CHECK(visited == vector<int>{50, 75, 60, 90});
+    CHECK(checked == vector<int>{50, 25, 75, 60, 90}); // 10 and 30 are never reached
+
+    visited.clear();
+    finished = tree.visit([](const Node<int> &)
+                          { return true; },
+                          [&](Node<int> &node)
+                          { visited.push_back(node.get_value());
+                            return node.get_value() != 30; });
+    CHECK_FALSE(finished);
+    CHECK(visited == vector<int>{50, 25, 10, 30});
+
+    Tree<int> empty;
+    CHECK(empty.visit([](const Node<int> &)
+                      { return true; },
+                      [](Node<int> &)
+                      { return false; }));
+}
+
+// Post-order for a 3-ary tree with a gap left by set_child
+TEST_CASE("Testing post-order on 3-ary tree with doubles that are not sorted")
+{
+    Node<double> root(1.1);
+    Tree<double> tree(3); // 3-ary tree
+
+    tree.add_root(root);
+
+    Node<double> n1(1.2);
+    Node<double> n2(1.8);
+    Node<double> n3(1.5);
+
+    tree.add_sub_node(root, n1);
+    tree.add_sub_node(root, n2);
+    tree.add_sub_node(root, n3);
+
+    Node<double> n4(1.7);
+    Node<double> n5(25.36);
+    Node<double> n6(12.11);
+    Node<double> n7(3.3);
+
+    tree.add_sub_node(n2, n4);
+    tree.add_sub_node(n2, n5);
+    tree.add_sub_node(n2, n7);
+    tree.add_sub_node(n4, n6);
+    tree.set_child(n2, 1, nullptr); // Leaves an empty slot between 1.7 and 3.3
+
+    vector<double> expected_post_order = {1.2, 12.11, 1.7, 3.3, 1.8, 1.5, 1.1};
+    vector<double> actual_post_order;
+    for (auto node = tree.begin_post_order(); node != tree.end_post_order(); ++node)
+    {
+        actual_post_order.push_back(node->get_value());
+    }
+    CHECK(expected_post_order == actual_post_order);
+
+    // Every node follows all of its descendants
+    std::map<Node<double> *, size_t> position;
+    for (Node<double> &node : tree.post_order())
+        position[&node] = position.size();
+    CHECK(position.size() == 7);
+    for (Node<double> &node : tree.pre_order())
+    {
+        if (node.get_parent())
+            CHECK(position[&node] < position[node.get_parent()]);
+    }
+
+    Tree<double> empty(3);
+    CHECK(empty.begin_post_order() == empty.end_post_order());
+}
+
+TEST_CASE("Testing k-ary in-order with a split point")
+{
+    Node<int> root(8);
+    Tree<int> tree(4); // 4-ary tree
+    tree.add_root(root);
+
+    Node<int> n1(2);
+    Node<int> n2(3);
+    Node<int> n3(4);
+    Node<int> n4(5);
+    Node<int> n5(6);
+    Node<int> n6(7);
+    Node<int> n7(1);
+    Node<int> n8(9);
+
+    tree.add_sub_node(root, n1);
+    tree.add_sub_node(root, n2);
+    tree.add_sub_node(root, n3);
+    tree.add_sub_node(root, n4);
+    tree.add_sub_node(n1, n5);
+    tree.add_sub_node(n1, n6);
+    tree.add_sub_node(n1, n8);
+    tree.add_sub_node(n6, n7);
+
+    auto collect = [&](size_t split)
+    {
+        vector<int> values;
+        for (auto node = tree.begin_in_order(split); node != tree.end_in_order(split); ++node)
+            values.push_back(node->get_value());
+        return values;
+    };
+
+    CHECK(collect(2) == vector<int>{6, 1, 7, 2, 9, 3, 8, 4, 5}); // Visit after the first ceil(k/2) children
+    CHECK(collect(1) == vector<int>{6, 2, 1, 7, 9, 8, 3, 4, 5});
+
+    vector<int> pre_order;
+    for (Node<int> &node : tree.pre_order())
+        pre_order.push_back(node.get_value());
+    CHECK(collect(0) == pre_order);
+
+    vector<int> post_order;
+    for (Node<int> &node : tree.post_order())
+        post_order.push_back(node.get_value());
+    CHECK(collect(4) == post_order);
+
+    // Empty slots are skipped on both sides of the split
+    tree.set_child(root, 0, nullptr);
+    tree.set_child(root, 2, nullptr);
+    CHECK(collect(2) == vector<int>{3, 8, 5});
+
+    // Split 1 on a binary tree matches the default in-order
+    Node<int> b1(4);
+    Tree<int> binary;
+    binary.add_root(b1);
+    Node<int> b2(2);
+    Node<int> b3(6);
+    Node<int> b4(1);
+    Node<int> b5(3);
+    binary.add_sub_node(b1, b2);
+    binary.add_sub_node(b1, b3);
+    binary.add_sub_node(b2, b4);
+    binary.add_sub_node(b2, b5);
+    vector<int> split_values;
+    for (Node<int> &node : binary.in_order(1))
+        split_values.push_back(node.get_value());
+    vector<int> default_values;
+    for (Node<int> &node : binary.in_order())
+        default_values.push_back(node.get_value());
+    CHECK(split_values == default_values);
+    CHECK(split_values == vector<int>{1, 2, 3, 4, 6});
+}
+
+TEST_CASE("Testing binary search tree mode")
+{
+    Tree<int> tree;
+    for (int value : {50, 30, 70, 20, 40, 60, 80, 65, 30})
+        tree.insert(value);
+
+    vector<int> in_order;
+    for (Node<int> &node : tree.in_order())
+        in_order.push_back(node.get_value());
+    CHECK(in_order == vector<int>{20, 30, 30, 40, 50, 60, 65, 70, 80});
+    CHECK(tree.subtree_size(*tree.get_root()) == 9);
+
+    Node<int> *found = tree.find(60);
+    REQUIRE(found != nullptr);
+    CHECK(found->get_value() == 60);
+    CHECK(found->get_children().size() == 2);
+    CHECK(found->get_children()[0] == nullptr); // Right child only, the left slot stays empty
+    CHECK(found->get_children()[1]->get_value() == 65);
+    CHECK(tree.find(55) == nullptr);
+
+    CHECK(tree.lower_bound(55)->get_value() == 60);
+    CHECK(tree.lower_bound(20)->get_value() == 20);
+    CHECK(tree.lower_bound(81) == nullptr);
+    Node<int> *first_thirty = tree.lower_bound(30);
+    CHECK(first_thirty == tree.find(30)); // The earlier duplicate comes first
+    CHECK(first_thirty->get_children()[1]->get_children()[0]->get_value() == 30);
+
+    // Complex uses its own ordering
+    Tree<Complex> complex_tree;
+    complex_tree.insert(Complex(2, 2));
+    complex_tree.insert(Complex(1, 5));
+    complex_tree.insert(Complex(2, 1));
+    complex_tree.insert(Complex(3, 0));
+    vector<Complex> complex_values;
+    for (Node<Complex> &node : complex_tree.in_order())
+        complex_values.push_back(node.get_value());
+    CHECK(std::is_sorted(complex_values.begin(), complex_values.end()));
+    CHECK(complex_tree.find(Complex(2, 1)) != nullptr);
+    CHECK(complex_tree.lower_bound(Complex(2, 1.5))->get_value() == Complex(2, 2));
+
+    Tree<int> ternary(3);
+    CHECK_THROWS_WITH(ternary.insert(1), "BST mode requires a binary tree.");
+}
+
+// Checks AVL balance, parent links and subtree sizes below a node, returning its height
+static int check_avl(Node<int> *node, Node<int> *parent)
+{
+    if (!node)
+        return 0;
+    CHECK(node->get_parent() == parent);
+    REQUIRE(node->get_children().size() == 2);
+    int left = check_avl(node->get_children()[0], node);
+    int right = check_avl(node->get_children()[1], node);
+    CHECK(std::abs(left - right) <= 1);
+    size_t size = 1;
+    for (auto child : node->get_children())
+        size += child ? child->get_subtree_size() : 0;
+    CHECK(node->get_subtree_size() == size);
+    return 1 + std::max(left, right);
+}
+
+TEST_CASE("Testing AVL tree on sorted, reverse and random inserts")
+{
+    const int count = 1023;
+    vector<int> sorted(count);
+    for (int i = 0; i < count; ++i)
+        sorted[i] = i;
+    vector<int> reversed(sorted.rbegin(), sorted.rend());
+    vector<int> shuffled = sorted;
+    std::mt19937 random(3);
+    std::shuffle(shuffled.begin(), shuffled.end(), random);
+
+    for (const vector<int> *input : {&sorted, &reversed, &shuffled})
+    {
+        AvlTree<int> tree;
+        for (int value : *input)
+            tree.insert(value);
+        CHECK(tree.size() == size_t(count));
+        CHECK(check_avl(tree.get_root(), nullptr) == tree.height());
+        CHECK(tree.height() <= 14); // 1.44 log2(n) bound
+
+        vector<int> values;
+        tree.for_each_in_order([&](int value)
+                               { values.push_back(value); });
+        CHECK(values == sorted);
+    }
+
+    AvlTree<int> sorted_tree;
+    for (int value : sorted)
+        sorted_tree.insert(value);
+    CHECK(sorted_tree.height() == 10); // Sorted input of 2^10 - 1 values fills every level
+
+    CHECK(sorted_tree.find(500)->get_value() == 500);
+    CHECK(sorted_tree.find(count) == nullptr);
+    CHECK(sorted_tree.lower_bound(-5)->get_value() == 0);
+    CHECK(sorted_tree.lower_bound(count) == nullptr);
+
+    // Duplicates keep their insertion order
+    AvlTree<int> duplicates;
+    Node<int> &first = duplicates.insert(7);
+    for (int value : {3, 7, 9, 7, 1})
+        duplicates.insert(value);
+    CHECK(duplicates.lower_bound(7) == &first);
+    vector<int> values;
+    duplicates.for_each_in_order([&](int value)
+                                 { values.push_back(value); });
+    CHECK(values == vector<int>{1, 3, 7, 7, 7, 9});
+}
+
+TEST_CASE("Testing van Emde Boas layout")
+{
+    Tree<int> tree;
+    for (int value : {8, 4, 12, 2, 6, 10, 14, 1, 3, 5, 7, 9, 11, 13, 15})
+        tree.insert(value);
+
+    VebLayout<int> layout(tree);
+    REQUIRE(layout.size() == 15);
+    // Top tree of two levels, then each three-node bottom tree in turn
+    vector<int> expected_layout = {8, 4, 12, 2, 1, 3, 6, 5, 7, 10, 9, 11, 14, 13, 15};
+    for (size_t i = 0; i < layout.size(); ++i)
+        CHECK(layout.value(i) == expected_layout[i]);
+
+    vector<int> in_order(layout.begin(), layout.end());
+    CHECK(in_order == vector<int>{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15});
+
+    for (int value = 1; value <= 15; ++value)
+        CHECK(layout.value(layout.find(value)) == value);
+    CHECK(layout.find(16) == VebLayout<int>::npos);
+    CHECK(*layout.lower_bound(0) == 1);
+    CHECK(layout.lower_bound(16) == layout.end());
+
+    // Uneven shapes, including right-only children with an empty left slot
+    Tree<int> chain;
+    for (int value : {1, 2, 3, 4, 5, 0})
+        chain.insert(value);
+    VebLayout<int> chain_layout(chain);
+    vector<int> chain_values(chain_layout.begin(), chain_layout.end());
+    CHECK(chain_values == vector<int>{0, 1, 2, 3, 4, 5});
+    CHECK(*chain_layout.lower_bound(3) == 3);
+
+    Tree<int> empty;
+    VebLayout<int> empty_layout(empty);
+    CHECK(empty_layout.size() == 0);
+    CHECK(empty_layout.begin() == empty_layout.end());
+    CHECK(empty_layout.find(1) == VebLayout<int>::npos);
+
+    Node<int> root(1);
+    Node<int> a(2);
+    Node<int> b(3);
+    Node<int> c(4);
+    Tree<int> ternary(3);
+    ternary.add_root(root);
+    ternary.add_sub_node(root, a);
+    ternary.add_sub_node(root, b);
+    ternary.add_sub_node(root, c);
+    CHECK_THROWS_WITH(VebLayout<int>{ternary}, "Van Emde Boas layout requires a binary tree.");
+}
+
+TEST_CASE("Testing Eytzinger layout")
+{
+    Tree<int> tree;
+    for (int value : {40, 20, 60, 10, 30, 50, 70, 35, 30})
+        tree.insert(value);
+
+    EytzingerLayout<int> layout(tree);
+    REQUIRE(layout.size() == 9);
+    CHECK(layout.value(1) == 40); // The implicit root has the five smallest values on its left
+    vector<int> scanned;
+    for (size_t i = layout.first(); i != EytzingerLayout<int>::npos; i = layout.next(i))
+        scanned.push_back(layout.value(i));
+    CHECK(scanned == vector<int>{10, 20, 30, 30, 35, 40, 50, 60, 70});
+
+    vector<int> sorted = scanned;
+    for (int key = 0; key <= 75; ++key)
+    {
+        auto expected = std::lower_bound(sorted.begin(), sorted.end(), key);
+        size_t found = layout.lower_bound(key);
+        if (expected == sorted.end())
+            CHECK(found == EytzingerLayout<int>::npos);
+        else
+            CHECK(layout.value(found) == *expected);
+        bool present = std::binary_search(sorted.begin(), sorted.end(), key);
+        CHECK((layout.find(key) != EytzingerLayout<int>::npos) == present);
+    }
+
+    // The first of equal values is found, so a scan sees every duplicate
+    size_t first_thirty = layout.lower_bound(30);
+    CHECK(layout.value(layout.next(first_thirty)) == 30);
+
+    EytzingerLayout<Complex> complex_layout(vector<Complex>{Complex(1, 1), Complex(1, 2), Complex(2, 0)});
+    CHECK(complex_layout.value(complex_layout.lower_bound(Complex(1, 1.5))) == Complex(1, 2));
+
+    EytzingerLayout<int> empty(vector<int>{});
+    CHECK(empty.size() == 0);
+    CHECK(empty.lower_bound(1) == EytzingerLayout<int>::npos);
+    CHECK(empty.first() == EytzingerLayout<int>::npos);
+}
+
+TEST_CASE("Testing subtree detach and removal")
+{
+    Tree<int> tree;
+    tree.set_aggregate(sum_op<int>());
+    for (int value : {50, 30, 70, 20, 40, 60, 80})
+        tree.insert(value);
+    Node<int> *thirty = tree.find(30);
+    Node<int> *twenty = tree.find(20);
+    Node<int> *forty = tree.find(40);
+    tree.build_lca_index();
+
+    // Detached subtrees keep their shape and can be reused
+    Node<int> *detached = tree.detach(*thirty);
+    CHECK(detached == thirty);
+    CHECK(thirty->get_parent() == nullptr);
+    CHECK(thirty->get_subtree_size() == 3);
+    CHECK(tree.subtree_size(*tree.get_root()) == 4);
+    CHECK(tree.subtree_aggregate(*tree.get_root()) == 260);
+    CHECK_THROWS_WITH(tree.subtree_aggregate(*thirty), "Node not found in aggregate cache.");
+    CHECK_THROWS_WITH(tree.lca(*tree.find(60), *tree.find(80)), "LCA index is not built.");
+    CHECK(tree.get_root()->get_children().size() == 2);
+    CHECK(tree.get_root()->get_children()[0] == nullptr); // The right child keeps its slot
+    CHECK(tree.find(20) == nullptr);
+    CHECK_THROWS_WITH(tree.detach(*twenty), "Node not found in tree.");
+
+    // Removed pool nodes are reused by later inserts instead of growing the pool
+    Node<int> *seventy = tree.find(70);
+    Node<int> *eighty = tree.find(80);
+    tree.remove_subtree(*tree.find(60));
+    tree.remove_subtree(*seventy);
+    CHECK(tree.get_root()->get_children().empty()); // Trailing empty slots are trimmed
+    CHECK(tree.subtree_aggregate(*tree.get_root()) == 50);
+    Node<int> &a = tree.insert(90);
+    Node<int> &b = tree.insert(10);
+    CHECK(&a == seventy); // The most recently recycled node is reused first
+    CHECK(&b == eighty);
+    CHECK(a.get_children().empty());
+    CHECK(tree.subtree_size(*tree.get_root()) == 3);
+    CHECK(tree.subtree_aggregate(*tree.get_root()) == 150);
+
+    vector<int> values;
+    for (Node<int> &node : tree.in_order())
+        values.push_back(node.get_value());
+    CHECK(values == vector<int>{10, 50, 90});
+
+    // Caller-owned nodes under a removed subtree are unlinked, not recycled
+    Node<int> mine(95);
+    tree.add_sub_node(a, mine);
+    tree.remove_subtree(a);
+    CHECK(mine.get_parent() == nullptr);
+    CHECK(mine.get_value() == 95);
+    CHECK(tree.subtree_size(*tree.get_root()) == 2);
+
+    // Pool nodes below a caller-owned node are cut off with their real sizes
+    Tree<int> mixed;
+    mixed.insert(50);
+    Node<int> &upper = mixed.insert(30);
+    Node<int> caller(25);
+    mixed.add_sub_node(upper, caller);
+    Node<int> &pooled_child = mixed.insert(27);
+    mixed.insert(28);
+    REQUIRE(pooled_child.get_parent() == &caller);
+    CHECK(caller.get_subtree_size() == 3);
+    mixed.remove_subtree(upper);
+    CHECK(caller.get_subtree_size() == 1);
+    CHECK(caller.get_children().empty());
+    CHECK(caller.get_parent() == nullptr);
+
+    // Detaching the root empties the tree
+    CHECK(tree.detach(*tree.get_root())->get_value() == 50);
+    CHECK(tree.get_root() == nullptr);
+    CHECK(forty->get_parent() == thirty);
+}
+
+TEST_CASE("Testing subtree moves")
+{
+    Node<int> root(1);
+    Tree<int> tree(3);
+    tree.add_root(root);
+    tree.set_aggregate(sum_op<int>());
+
+    Node<int> n2(2);
+    Node<int> n3(3);
+    Node<int> n4(4);
+    Node<int> n5(5);
+    Node<int> n6(6);
+    tree.add_sub_node(root, n2);
+    tree.add_sub_node(root, n3);
+    tree.add_sub_node(n2, n4);
+    tree.add_sub_node(n4, n5);
+    tree.add_sub_node(n3, n6);
+    tree.build_lca_index();
+
+    // Move the 4-5 chain under 3, leaving a gap before it
+    tree.move_subtree(n4, n3, 2);
+    CHECK(n4.get_parent() == &n3);
+    CHECK(n2.get_children().empty());
+    REQUIRE(n3.get_children().size() == 3);
+    CHECK(n3.get_children()[0] == &n6);
+    CHECK(n3.get_children()[1] == nullptr);
+    CHECK(n3.get_children()[2] == &n4);
+    CHECK(tree.subtree_size(n2) == 1);
+    CHECK(tree.subtree_size(n3) == 4);
+    CHECK(tree.subtree_aggregate(n2) == 2);
+    CHECK(tree.subtree_aggregate(n3) == 18);
+    CHECK(tree.subtree_aggregate(root) == 21);
+    CHECK(tree.depth(n5) == 3);
+    CHECK_THROWS_WITH(tree.lca(n5, n6), "LCA index is not built.");
+
+    // Fill the gap within the same parent
+    tree.move_subtree(n4, n3, 1);
+    CHECK(n3.get_children().size() == 2);
+    CHECK(n3.get_children()[1] == &n4);
+
+    CHECK_THROWS_WITH(tree.move_subtree(n3, n5, 0), "Cannot move a node into its own subtree.");
+    CHECK_THROWS_WITH(tree.move_subtree(n4, n4, 0), "Cannot move a node into its own subtree.");
+    CHECK_THROWS_WITH(tree.move_subtree(root, n2, 0), "Cannot move the root.");
+    CHECK_THROWS_WITH(tree.move_subtree(n2, n3, 3), "Maximum children exceeded");
+    CHECK_THROWS_WITH(tree.move_subtree(n2, n3, 0), "Child slot is occupied.");
+    Node<int> outside(7);
+    CHECK_THROWS_WITH(tree.move_subtree(outside, n2, 0), "Node not found in tree.");
+    CHECK(tree.subtree_aggregate(root) == 21); // Rejected moves change nothing
+
+    tree.build_lca_index();
+    CHECK(tree.lca(n5, n6) == &n3);
+}
+
+TEST_CASE("Testing tree copy and move")
+{
+    Node<int> root(1);
+    Tree<int> tree(3);
+    tree.add_root(root);
+    tree.set_aggregate(sum_op<int>());
+    Node<int> n2(2);
+    Node<int> n3(3);
+    Node<int> n4(4);
+    Node<int> n5(5);
+    tree.add_sub_node(root, n2);
+    tree.add_sub_node(root, n3);
+    tree.add_sub_node(n2, n4);
+    tree.add_sub_node(n3, n5);
+    tree.set_child(root, 0, nullptr); // An empty slot must survive the copy
+    tree.add_sub_node(n3, n2);
+
+    auto pre_order_of = [](const Tree<int> &source)
+    {
+        vector<int> values;
+        for (Node<int> &node : source.pre_order())
+            values.push_back(node.get_value());
+        return values;
+    };
+
+    Tree<int> copy(tree);
+    CHECK(pre_order_of(copy) == pre_order_of(tree));
+    CHECK(copy.get_root() != tree.get_root());
+    REQUIRE(copy.get_root()->get_children().size() == 2);
+    CHECK(copy.get_root()->get_children()[0] == nullptr);
+    CHECK(copy.subtree_size(*copy.get_root()) == 5);
+    CHECK(copy.subtree_aggregate(*copy.get_root()) == 15);
+    for (Node<int> &node : copy.pre_order())
+    {
+        CHECK(&node != &root);
+        CHECK(&node != &n2);
+        CHECK(&node != &n3);
+        CHECK(&node != &n4);
+        CHECK(&node != &n5);
+    }
+
+    // Changing the copy leaves the original alone
+    Node<int> n6(6);
+    copy.add_sub_node(*copy.get_root(), n6);
+    CHECK(copy.subtree_aggregate(*copy.get_root()) == 21);
+    copy.set_value(*copy.get_root(), 10);
+    CHECK(copy.subtree_aggregate(*copy.get_root()) == 30);
+    CHECK(tree.subtree_aggregate(root) == 15);
+    CHECK(root.get_value() == 1);
+    CHECK(root.get_children().size() == 2);
+
+    // Moves keep node addresses and leave an empty tree behind
+    Node<int> *copied_root = copy.get_root();
+    Tree<int> moved(std::move(copy));
+    CHECK(moved.get_root() == copied_root);
+    CHECK(copy.get_root() == nullptr);
+    CHECK(moved.subtree_aggregate(*copied_root) == 30);
+    CHECK_THROWS_WITH(copy.subtree_aggregate(*copied_root), "Aggregate not set.");
+
+    Tree<int> assigned;
+    assigned = tree;
+    CHECK(pre_order_of(assigned) == pre_order_of(tree));
+    CHECK(assigned.get_root() != &root);
+    assigned = std::move(moved);
+    CHECK(assigned.get_root() == copied_root);
+    assigned = assigned;
+    CHECK(assigned.get_root() == copied_root);
+
+    // Copies of BST-mode trees keep working as search trees
+    Tree<int> search;
+    for (int value : {5, 3, 8, 9})
+        search.insert(value);
+    Tree<int> search_copy = search;
+    search_copy.insert(7);
+    CHECK(search_copy.find(7) != nullptr);
+    CHECK(search.find(7) == nullptr);
+    CHECK(search_copy.find(9) != search.find(9));
+}
+
+// Orderable but without std::hash, so a tree of these only works while hashing stays off
+struct Unhashed
+{
+    int id;
+    bool operator<(const Unhashed &other) const { return id < other.id; }
+    bool operator>(const Unhashed &other) const { return other < *this; }
+    bool operator==(const Unhashed &other) const { return id == other.id; }
+};
+
+TEST_CASE("Testing trees of values without std::hash")
+{
+    Node<Unhashed> root(Unhashed{1});
+    Node<Unhashed> child(Unhashed{2});
+    Node<Unhashed> other(Unhashed{3});
+    Tree<Unhashed> tree(3);
+    tree.add_root(root);
+    tree.add_sub_node(root, child);
+    tree.add_sub_node(root, other);
+    tree.set_value(child, Unhashed{4});
+    tree.move_subtree(other, child, 0);
+    tree.set_child(child, 0, nullptr);
+    CHECK(tree.subtree_size(root) == 2);
+    CHECK(tree.detach(child) == &child);
+
+    Tree<Unhashed> search;
+    for (int id : {5, 3, 8})
+        search.insert(Unhashed{id});
+    Tree<Unhashed> copy = search;
+    CHECK(search.equals(copy));
+    search.remove_subtree(*search.find(Unhashed{3}));
+    CHECK_FALSE(search.equals(copy));
+    CHECK(search.diff(copy).size() == 1);
+}
+
+// No default constructor, so the aggregate cache must never default-construct a value
+struct Weight
+{
+    explicit Weight(int grams) : grams(grams) {}
+    int grams;
+    bool operator<(const Weight &other) const { return grams < other.grams; }
+    bool operator>(const Weight &other) const { return other < *this; }
+    bool operator==(const Weight &other) const { return grams == other.grams; }
+};
+
+TEST_CASE("Testing aggregates of values without a default constructor")
+{
+    Node<Weight> root(Weight(1));
+    Node<Weight> child(Weight(2));
+    Node<Weight> other(Weight(4));
+    Tree<Weight> tree(3);
+    tree.set_aggregate([](const Weight &a, const Weight &b)
+                       { return Weight(a.grams + b.grams); });
+    tree.add_root(root);
+    tree.add_sub_node(root, child);
+    tree.add_sub_node(root, other);
+    CHECK(tree.subtree_aggregate(root).grams == 7);
+    tree.set_value(child, Weight(8));
+    CHECK(tree.subtree_aggregate(root).grams == 13);
+    tree.move_subtree(other, child, 0);
+    CHECK(tree.subtree_aggregate(child).grams == 12);
+    Tree<Weight> copy = tree;
+    CHECK(copy.subtree_aggregate(*copy.get_root()).grams == 13);
+    tree.set_child(child, 0, nullptr);
+    CHECK(tree.subtree_aggregate(root).grams == 9);
+    tree.detach(child);
+    CHECK(tree.subtree_aggregate(root).grams == 1);
+    Node<Weight> late(Weight(16));
+    tree.add_sub_node_concurrent(root, late);
+    CHECK(tree.subtree_aggregate(root).grams == 17);
+}
+
+TEST_CASE("Testing subtree hashes, equality and diff")
+{
+    Tree<int> a;
+    Tree<int> b;
+    a.enable_hashing();
+    b.enable_hashing();
+    for (int value : {50, 30, 70, 20, 40, 60, 80})
+    {
+        a.insert(value);
+        b.insert(value);
+    }
+    CHECK(a.equals(b));
+    CHECK(a.subtree_hash(*a.get_root()) == b.subtree_hash(*b.get_root()));
+    CHECK(a.diff(b).empty());
+    CHECK(a.subtree_hash(*a.find(30)) != a.subtree_hash(*a.find(70)));
+
+    // Hashes follow inserts incrementally
+    a.insert(65);
+    CHECK_FALSE(a.equals(b));
+    auto differences = a.diff(b);
+    REQUIRE(differences.size() == 1);
+    CHECK(differences[0].first == a.find(65));
+    CHECK(differences[0].second == nullptr);
+    b.insert(65);
+    CHECK(a.equals(b));
+
+    // A changed value is reported where it sits, ancestors with equal values are not
+    Tree<int> c = a;
+    Node<int> *sixty = c.find(60);
+    c.set_value(*sixty, 61); // Rehashes the path above the node
+    differences = a.diff(c);
+    REQUIRE(differences.size() == 1);
+    CHECK(differences[0].first == a.find(60));
+    CHECK(differences[0].second == sixty);
+
+    // Identical subtrees in different trees and positions share a hash
+    Tree<int> d;
+    d.enable_hashing();
+    for (int value : {60, 65})
+        d.insert(value);
+    CHECK(d.subtree_hash(*d.get_root()) == a.subtree_hash(*a.find(60)));
+
+    // Removal and moves keep hashes current
+    Tree<int> e = a;
+    e.remove_subtree(*e.find(65));
+    a.remove_subtree(*a.find(65));
+    CHECK(a.equals(e));
+    CHECK_FALSE(a.equals(b));
+
+    // A subtree replaced through set_child leaves the hash cache
+    Tree<int> f = b;
+    Node<int> *replaced = f.find(20);
+    f.set_child(*f.find(30), 0, nullptr);
+    CHECK_THROWS_WITH(f.subtree_hash(*replaced), "Node not found in hash cache.");
+    CHECK(f.subtree_hash(*f.get_root()) != b.subtree_hash(*b.get_root()));
+
+    // Concurrent inserts are hashed when the next query folds them in
+    Node<int> extra_a(90);
+    Node<int> extra_b(90);
+    a.add_sub_node_concurrent(*a.find(80), extra_a);
+    e.add_sub_node(*e.find(80), extra_b);
+    CHECK(a.subtree_hash(*a.get_root()) == e.subtree_hash(*e.get_root()));
+    CHECK(a.equals(e));
+
+    // Sequential changes right after concurrent inserts, with no query in between
+    Node<int> concurrent_a(95);
+    Node<int> concurrent_b(95);
+    Node<int> below_a(96);
+    Node<int> below_b(96);
+    Node<int> moved_a(97);
+    Node<int> moved_b(97);
+    Node<int> sibling_a(94);
+    Node<int> sibling_b(94);
+    a.add_sub_node_concurrent(extra_a, concurrent_a);
+    a.add_sub_node_concurrent(extra_a, sibling_a);
+    a.add_sub_node(concurrent_a, below_a); // Rehashing extra_a needs the sibling's hash
+    e.add_sub_node(extra_b, concurrent_b);
+    e.add_sub_node(extra_b, sibling_b);
+    e.add_sub_node(concurrent_b, below_b);
+    CHECK(a.equals(e));
+    a.add_sub_node_concurrent(below_a, moved_a);
+    a.set_child(*a.find(30), 0, nullptr);
+    e.add_sub_node(below_b, moved_b);
+    e.set_child(*e.find(30), 0, nullptr);
+    CHECK(a.equals(e));
+    Node<int> late_a(98);
+    Node<int> late_b(98);
+    a.add_sub_node_concurrent(moved_a, late_a);
+    a.move_subtree(moved_a, concurrent_a, 1);
+    a.set_value(late_a, 99);
+    e.add_sub_node(moved_b, late_b);
+    e.move_subtree(moved_b, concurrent_b, 1);
+    e.set_value(late_b, 99);
+    CHECK(a.equals(e));
+    CHECK(a.subtree_hash(late_a) == e.subtree_hash(late_b));
+    Node<int> last_a(100);
+    a.add_sub_node_concurrent(late_a, last_a);
+    a.detach(moved_a);
+    e.detach(moved_b);
+    CHECK(a.equals(e));
+    CHECK_THROWS_WITH(a.subtree_hash(last_a), "Node not found in hash cache.");
+
+    // Without hashing, equals and diff walk both trees
+    Node<int> r1(1);
+    Node<int> r2(1);
+    Node<int> c1(2);
+    Node<int> c2(3);
+    Tree<int> plain1(3);
+    Tree<int> plain2(3);
+    plain1.add_root(r1);
+    plain2.add_root(r2);
+    plain1.add_sub_node(r1, c1);
+    plain2.add_sub_node(r2, c2);
+    CHECK_FALSE(plain1.equals(plain2));
+    differences = plain1.diff(plain2);
+    REQUIRE(differences.size() == 1);
+    CHECK(differences[0] == std::make_pair(&c1, &c2));
+    CHECK_THROWS_WITH(plain1.subtree_hash(r1), "Hashing not enabled.");
+
+    Tree<int> empty1;
+    Tree<int> empty2;
+    empty1.enable_hashing();
+    empty2.enable_hashing();
+    CHECK(empty1.equals(empty2));
+    CHECK_FALSE(empty1.equals(a));
+}
@@ -12,21 +12,108 @@
 #include "node.hpp"          // Including the Node class definition
 #include <map>               // For mapping nodes to positions in visualization
 #include "complex.hpp"       // For handling complex numbers
+#include "complex_batch.hpp" // For vectorized comparisons of complex values
 #include <sstream>           // For string stream
+#include <unordered_map>     // For node lookups in the LCA index and aggregate cache
+#include <functional>        // For std::function holding the aggregate operation
+#include <memory>            // For std::shared_ptr holding published nodes
+#include <atomic>            // For index invalidation during concurrent inserts
+#include <iterator>          // For iterator category tags
+#include <cstddef>           // For std::ptrdiff_t
+#include <variant>           // For the traversal state held by a walker
+#include <mutex>             // For the per-thread logs of concurrent inserts
+#include <array>             // For the fixed set of concurrent insert logs
+#include <deque>             // For the tree-owned node pool with stable addresses
+#include <unordered_set>     // For telling pool-owned nodes from caller-owned ones
+#include <cstdint>           // For 64-bit subtree hashes and reader epochs
+#include "persistent_tree.hpp" // For the shared immutable nodes of published versions
+
+// Commutative monoid operations usable as subtree aggregates
+template <typename T>
+struct sum_op
+{
+    T operator()(const T &a, const T &b) const { return a + b; }
+};
+
+template <typename T>
+struct min_op
+{
+    T operator()(const T &a, const T &b) const { return b < a ? b : a; }
+};
+
+template <typename T>
+struct max_op
+{
+    T operator()(const T &a, const T &b) const { return a < b ? b : a; }
+};
 
 template <typename T>
 class Tree
 {
 public:
-    explicit Tree(size_t k = 2) : root(nullptr), k(k) {} // Constructor with default k value
+    explicit Tree(size_t k = 2) : root(nullptr), k(k), lca_valid(false) {} // Constructor with default k value
+
+    // Deep copy into this tree's pool; the copy shares no nodes with other
+    Tree(const Tree &other) : root(nullptr), k(other.k), lca_valid(false), aggregate_op(other.aggregate_op)
+    {
+        hashing = other.hashing;
+        value_hash = other.value_hash;
+        other.settle(); // Copy current sizes and caches rather than ones missing concurrent inserts
+        root = clone(other);
+        if (const version *theirs = other.published.load())
+            published = new version{theirs->root}; // Versions are immutable, so both trees can share the nodes
+    }
+
+    // Takes over the nodes, pool and indexes of other without copying; node addresses stay the same
+    Tree(Tree &&other) noexcept : root(nullptr), k(other.k), lca_valid(false)
+    {
+        take(other);
+    }
+
+    Tree &operator=(const Tree &other)
+    {
+        if (this != &other)
+        {
+            Tree copy(other);
+            take(copy); // Build first, so a failed copy leaves this tree unchanged
+        }
+        return *this;
+    }
+
+    Tree &operator=(Tree &&other) noexcept
+    {
+        if (this != &other)
+            take(other);
+        return *this;
+    }
 
     void add_root(Node<T> &node)
     {
-        root = &node; // Setting the root node of the tree
+        settle();          // Concurrent inserts belong to the old root
+        root = &node;      // Setting the root node of the tree
+        structure_changed();
+        published_nodes.clear(); // The next publish copies the new root's tree
+        unpublished.clear();
+        if (aggregate_op)
+        {
+            aggregates.clear();
+            compute_aggregate(root); // Rebuild aggregates for the new root
+        }
+        if (hashing)
+        {
+            hashes.clear();
+            hash_subtree(root); // Rebuild hashes for the new root
+        }
+    }
+
+    Node<T> *get_root() const
+    {
+        return root; // Root node, nullptr if not set
     }
 
     void add_sub_node(Node<T> &parent, Node<T> &child)
     {
+        settle();
         if (!root)
         {
             throw std::runtime_error("Error: Root not set."); // Throw error if root is not set
@@ -36,6 +123,12 @@ public:
         if (parentNode)
         {
             parentNode->add_child(&child, k); // Add child to parent node if found
+            structure_changed();
+            mark_unpublished(parentNode);
+            if (aggregate_op)
+                fold_into_ancestors(parentNode, &child);
+            if (hashing)
+                rehash_from(parentNode, &child);
         }
         else
         {
@@ -49,15 +142,791 @@ public:
         throw std::runtime_error("Child node type does not match"); // Prevent adding child of different type
     }
 
+    // Thread-safe insert directly under parent; inserts under different parents run in parallel.
+    // Only the parent's child list and this thread's log are written. Subtree sizes, aggregates and
+    // hashes above the new node are folded in by the next query or change on this tree, or by sync,
+    // none of which may overlap with the inserting threads.
+    void add_sub_node_concurrent(Node<T> &parent, Node<T> &child)
+    {
+        if (!root)
+        {
+            throw std::runtime_error("Error: Root not set."); // Throw error if root is not set
+        }
+        if (!contains(parent))
+        {
+            throw std::runtime_error("Parent node not found."); // Validate before linking anything
+        }
+
+        size_t size = child.get_subtree_size();
+        parent.link_child_concurrent(&child, k); // Only the parent's child list is locked
+        pending_log &log = pending[thread_log()];
+        {
+            std::lock_guard<std::mutex> guard(log.lock); // Uncontended unless threads outnumber logs
+            log.links.emplace_back(&child, size);
+        }
+        if (!has_pending.load(std::memory_order_relaxed))
+            has_pending = true; // Test first, so threads do not keep writing a shared line
+        if (lca_valid.load(std::memory_order_relaxed))
+            lca_valid = false;
+    }
+
+    // Folds the sizes, aggregates and hashes of concurrent inserts into the tree. Queries and changes
+    // do this on their own; call it after the inserting threads join to read Node sizes directly.
+    void sync() const
+    {
+        settle();
+    }
+
+    void set_child(Node<T> &parent, size_t index, Node<T> *child)
+    {
+        settle();
+        const auto &slots = parent.get_children();
+        Node<T> *replaced = index < slots.size() ? slots[index] : nullptr;
+        if (replaced && replaced != child && (aggregate_op || hashing || !published_nodes.empty()))
+            forget_cached(replaced);    // The replaced subtree leaves the caches, as after detach
+        parent.set_child(index, child); // Replace the child slot
+        structure_changed();
+        mark_unpublished(&parent);
+        if (aggregate_op && aggregates.count(&parent))
+        {
+            if (child)
+                compute_aggregate(child);
+            for (Node<T> *current = &parent; current != nullptr; current = current->get_parent())
+            {
+                aggregates.insert_or_assign(current, fold_children(current)); // Removed values cannot be subtracted, so refold
+            }
+        }
+        if (hashing && hashes.count(&parent))
+            rehash_from(&parent, child);
+    }
+
+    // Changes a node's value and refreshes the aggregates and hashes on its ancestor path.
+    // Path indexes reload values on their next use; Node::set_value bypasses all of these.
+    void set_value(Node<T> &node, const T &value)
+    {
+        if (!contains(node))
+            throw std::runtime_error("Node not found in tree."); // Only nodes under this root are cached
+
+        settle();
+        node.set_value(value);
+        ++value_version;
+        mark_unpublished(&node);
+        if (aggregate_op)
+        {
+            for (Node<T> *current = &node; current != nullptr; current = current->get_parent())
+                aggregates.insert_or_assign(current, fold_children(current)); // The old value cannot be subtracted, so refold
+        }
+        if (hashing)
+            rehash_from(&node, nullptr);
+    }
+
+    // Ordered insert for binary search tree use, with storage owned by the tree.
+    // Equal values go right, so duplicates keep their insertion order in in-order traversal.
+    Node<T> &insert(const T &value)
+    {
+        require_binary();
+        settle();
+        Node<T> *node = allocate(value);
+        if (!root)
+        {
+            add_root(*node);
+            return *node;
+        }
+
+        Node<T> *parent = root;
+        size_t slot = 0;
+        while (true)
+        {
+            slot = value < parent->get_value() ? 0 : 1;
+            Node<T> *next = child_at(parent, slot);
+            if (!next)
+                break;
+            parent = next; // Descend one level per comparison
+        }
+
+        if (slot < parent->get_children().size())
+        {
+            parent->set_child(slot, node); // Fill the empty left slot kept for this position
+        }
+        else
+        {
+            if (slot == 1 && parent->get_children().empty())
+                parent->add_empty_slot(k); // A right child alone keeps the left slot empty
+            parent->add_child(node, k);
+        }
+        structure_changed();
+        mark_unpublished(parent);
+        if (aggregate_op)
+            fold_into_ancestors(parent, node);
+        if (hashing)
+            rehash_from(parent, node);
+        return *node;
+    }
+
+    // O(depth) search of a tree built in binary search order, nullptr if absent
+    Node<T> *find(const T &value) const
+    {
+        require_binary();
+        Node<T> *current = root;
+        while (current)
+        {
+            if (value < current->get_value())
+                current = child_at(current, 0);
+            else if (current->get_value() < value)
+                current = child_at(current, 1);
+            else
+                return current; // Neither is less, so the values are equivalent
+        }
+        return nullptr;
+    }
+
+    // First node in in-order whose value is not less than value, nullptr if there is none
+    Node<T> *lower_bound(const T &value) const
+    {
+        require_binary();
+        Node<T> *result = nullptr;
+        Node<T> *current = root;
+        while (current)
+        {
+            if (current->get_value() < value)
+            {
+                current = child_at(current, 1);
+            }
+            else
+            {
+                result = current; // Candidate, keep looking for an earlier one on the left
+                current = child_at(current, 0);
+            }
+        }
+        return result;
+    }
+
+    // Unlinks a subtree from its parent, or empties the tree for the root, and returns its root.
+    // The subtree keeps its own structure and can be attached again, here or in another tree.
+    Node<T> *detach(Node<T> &node)
+    {
+        if (!contains(node))
+            throw std::runtime_error("Node not found in tree."); // Only nodes under this root can be detached
+        settle();
+
+        Node<T> *parent = node.get_parent();
+        structure_changed();
+        if (aggregate_op || hashing || !published_nodes.empty())
+            forget_cached(&node);
+        if (!parent)
+        {
+            root = nullptr; // Detaching the root empties the tree
+            return &node;
+        }
+
+        const auto &children = parent->get_children();
+        parent->set_child(std::find(children.begin(), children.end(), &node) - children.begin(), nullptr);
+        parent->trim_empty_slots(); // Keep slots that hold a later sibling's position
+        mark_unpublished(parent);
+        if (aggregate_op)
+        {
+            for (Node<T> *current = parent; current != nullptr; current = current->get_parent())
+                aggregates.insert_or_assign(current, fold_children(current)); // Removed values cannot be subtracted, so refold
+        }
+        if (hashing)
+            rehash_from(parent, nullptr);
+        return &node;
+    }
+
+    // Detaches a subtree and returns the nodes created by insert to the pool for reuse.
+    // Caller-owned nodes in the subtree are only unlinked from pool nodes and stay with the caller.
+    void remove_subtree(Node<T> &node)
+    {
+        detach(node);
+
+        // Post-order, so every node is recycled after its children
+        std::vector<std::pair<Node<T> *, size_t>> stack = {{&node, 0}};
+        while (!stack.empty())
+        {
+            Node<T> *current = stack.back().first;
+            size_t &next = stack.back().second;
+            const auto &children = current->get_children();
+            if (next < children.size())
+            {
+                Node<T> *child = children[next++];
+                if (child)
+                    stack.emplace_back(child, 0);
+                continue;
+            }
+            stack.pop_back();
+
+            bool owned = pooled.count(current) != 0;
+            for (size_t i = 0; i < children.size(); ++i)
+            {
+                if (children[i] && owned != (pooled.count(children[i]) != 0))
+                    current->set_child(i, nullptr); // No link may join a recycled node and a caller-owned one
+            }
+            if (owned)
+            {
+                Node<T> *parent = current->get_parent();
+                if (parent && pooled.count(parent) == 0)
+                {
+                    // Unlink while current still has its real size, so the caller-owned parent subtracts it
+                    const auto &siblings = parent->get_children();
+                    parent->set_child(std::find(siblings.begin(), siblings.end(), current) - siblings.begin(), nullptr);
+                }
+                *current = Node<T>(current->get_value()); // Drop all links before reuse
+                free_nodes.push_back(current);
+            }
+            else
+            {
+                current->trim_empty_slots();
+            }
+        }
+    }
+
+    // Relinks a subtree under another parent without copying it. index may name an empty slot or lie
+    // past the end of the child list, in which case empty slots are added up to it.
+    void move_subtree(Node<T> &node, Node<T> &new_parent, size_t index)
+    {
+        if (!contains(node) || !contains(new_parent))
+            throw std::runtime_error("Node not found in tree."); // Both ends must be under this root
+        if (&node == root)
+            throw std::runtime_error("Cannot move the root.");
+        if (is_ancestor(node, new_parent))
+            throw std::runtime_error("Cannot move a node into its own subtree."); // Would create a cycle
+        if (index >= k)
+            throw std::runtime_error("Maximum children exceeded");
+        const auto &slots = new_parent.get_children();
+        if (index < slots.size() && slots[index] && slots[index] != &node)
+            throw std::runtime_error("Child slot is occupied.");
+        settle();
+
+        Node<T> *old_parent = node.get_parent();
+        const auto &siblings = old_parent->get_children();
+        old_parent->set_child(std::find(siblings.begin(), siblings.end(), &node) - siblings.begin(), nullptr);
+        old_parent->trim_empty_slots();
+        if (aggregate_op)
+        {
+            for (Node<T> *current = old_parent; current != nullptr; current = current->get_parent())
+                aggregates.insert_or_assign(current, fold_children(current)); // Removed values cannot be subtracted, so refold
+        }
+
+        while (new_parent.get_children().size() < index)
+            new_parent.add_empty_slot(k); // Pad up to the requested position
+        if (index < new_parent.get_children().size())
+            new_parent.set_child(index, &node);
+        else
+            new_parent.add_child(&node, k);
+
+        structure_changed();
+        mark_unpublished(old_parent); // The moved subtree itself is unchanged, so its published copy is reused
+        mark_unpublished(&new_parent);
+        if (hashing)
+        {
+            rehash_from(old_parent, nullptr); // The moved subtree's own hashes are unchanged
+            rehash_from(&new_parent, nullptr);
+        }
+        if (aggregate_op)
+        {
+            T moved = aggregates.at(&node); // The moved subtree's own aggregates are unchanged
+            for (Node<T> *current = &new_parent; current != nullptr; current = current->get_parent())
+            {
+                T &cached = aggregates.at(current);
+                cached = aggregate_op(cached, moved);
+            }
+        }
+    }
+
+    // Maintains a Merkle hash per subtree from now on. Each insert or removal rehashes only its
+    // ancestor path; inserts from add_sub_node_concurrent are hashed when they are folded in.
+    // Only this method needs std::hash<T>, so trees that never hash work with any T.
+    void enable_hashing()
+    {
+        settle();
+        hashing = true;
+        value_hash = [](const T &value)
+        { return static_cast<uint64_t>(std::hash<T>()(value)); };
+        hashes.clear();
+        if (root)
+            hash_subtree(root);
+    }
+
+    uint64_t subtree_hash(const Node<T> &node) const
+    {
+        if (!hashing)
+        {
+            throw std::runtime_error("Hashing not enabled."); // Throw error if enable_hashing was not called
+        }
+        settle();
+        auto it = hashes.find(&node);
+        if (it == hashes.end())
+        {
+            throw std::runtime_error("Node not found in hash cache."); // Throw error if the node is not in the tree
+        }
+        return it->second;
+    }
+
+    // Same shape and values. With hashing on in both trees this is one hash comparison, so equal
+    // 64-bit root hashes are taken as equal trees; otherwise both trees are walked until a difference.
+    bool equals(const Tree &other) const
+    {
+        if (hashing && other.hashing)
+        {
+            settle();
+            other.settle();
+            if (!root || !other.root)
+                return !root && !other.root; // Empty trees have no hash
+            return hashes.at(root) == other.hashes.at(other.root);
+        }
+        bool same = true;
+        walk_differences(other, [&](Node<T> *, Node<T> *)
+                         { same = false;
+                           return false; }); // Stop at the first difference
+        return same;
+    }
+
+    // Pairs of nodes at the same position whose values differ, with nullptr on the side that has no
+    // node there. With hashing on in both trees, unchanged subtrees are skipped by their hashes.
+    std::vector<std::pair<Node<T> *, Node<T> *>> diff(const Tree &other) const
+    {
+        settle();
+        other.settle();
+        std::vector<std::pair<Node<T> *, Node<T> *>> differences;
+        walk_differences(other, [&](Node<T> *mine, Node<T> *theirs)
+                         { differences.emplace_back(mine, theirs);
+                           return true; });
+        return differences;
+    }
+
+    template <typename Op>
+    void set_aggregate(Op op)
+    {
+        settle();
+        aggregate_op = op;
+        aggregates.clear();
+        if (root)
+            compute_aggregate(root); // Cache the aggregate of every subtree
+    }
+
+    T subtree_aggregate(const Node<T> &node) const
+    {
+        if (!aggregate_op)
+        {
+            throw std::runtime_error("Aggregate not set."); // Throw error if no operation was configured
+        }
+        settle();
+        auto it = aggregates.find(&node);
+        if (it == aggregates.end())
+        {
+            throw std::runtime_error("Node not found in aggregate cache."); // Throw error if the node is not in the tree
+        }
+        return it->second;
+    }
+
+    size_t subtree_size(const Node<T> &node) const
+    {
+        settle();
+        return node.get_subtree_size(); // Maintained by the nodes on every insert
+    }
+
+    std::vector<Node<T> *> path_to_root(Node<T> &node) const
+    {
+        std::vector<Node<T> *> path;
+        for (Node<T> *current = &node; current != nullptr; current = current->get_parent())
+        {
+            path.push_back(current); // Follow parent links up to the root
+        }
+        return path;
+    }
+
+    size_t depth(const Node<T> &node) const
+    {
+        size_t result = 0;
+        for (const Node<T> *current = node.get_parent(); current != nullptr; current = current->get_parent())
+        {
+            ++result; // Count edges up to the root
+        }
+        return result;
+    }
+
+    bool is_ancestor(const Node<T> &ancestor, const Node<T> &node) const
+    {
+        if (lca_valid)
+        {
+            auto a = entry_time.find(&ancestor);
+            auto b = entry_time.find(&node);
+            if (a != entry_time.end() && b != entry_time.end())
+            {
+                // Nested entry/exit intervals mean the subtree contains the node
+                return a->second <= b->second && exit_time.at(&node) <= exit_time.at(&ancestor);
+            }
+        }
+        for (const Node<T> *current = &node; current != nullptr; current = current->get_parent())
+        {
+            if (current == &ancestor)
+                return true; // A node counts as its own ancestor
+        }
+        return false;
+    }
+
+    // Euler tour + sparse table over tour depths, giving O(1) LCA queries
+    void build_lca_index()
+    {
+        euler.clear();
+        euler_depth.clear();
+        first_visit.clear();
+        entry_time.clear();
+        exit_time.clear();
+        sparse.clear();
+        log_table.clear();
+        lca_valid = true;
+        if (!root)
+            return;
+
+        size_t timer = 0;
+        std::vector<std::pair<Node<T> *, size_t>> stack; // Node and index of next child to visit
+        stack.emplace_back(root, 0);
+        first_visit[root] = 0;
+        entry_time[root] = timer++;
+        euler.push_back(root);
+        euler_depth.push_back(0);
+        while (!stack.empty())
+        {
+            Node<T> *node = stack.back().first;
+            size_t &next = stack.back().second;
+            const auto &children = node->get_children();
+            while (next < children.size() && children[next] == nullptr)
+                ++next; // Skip empty child slots
+            if (next < children.size())
+            {
+                Node<T> *child = children[next++];
+                first_visit[child] = euler.size();
+                entry_time[child] = timer++;
+                euler.push_back(child);
+                euler_depth.push_back(stack.size());
+                stack.emplace_back(child, 0);
+            }
+            else
+            {
+                exit_time[node] = timer++;
+                stack.pop_back();
+                if (!stack.empty())
+                {
+                    euler.push_back(stack.back().first); // Return to the parent
+                    euler_depth.push_back(stack.size() - 1);
+                }
+            }
+        }
+
+        size_t n = euler.size();
+        log_table.assign(n + 1, 0);
+        for (size_t i = 2; i <= n; ++i)
+            log_table[i] = log_table[i / 2] + 1; // Floor of log2 for every range length
+        sparse.push_back(std::vector<size_t>(n));
+        for (size_t i = 0; i < n; ++i)
+            sparse[0][i] = i;
+        for (size_t level = 1; (size_t(1) << level) <= n; ++level)
+        {
+            size_t half = size_t(1) << (level - 1);
+            std::vector<size_t> row(n - (size_t(1) << level) + 1);
+            for (size_t i = 0; i < row.size(); ++i)
+            {
+                size_t left = sparse[level - 1][i];
+                size_t right = sparse[level - 1][i + half];
+                row[i] = euler_depth[left] <= euler_depth[right] ? left : right; // Keep the shallower entry
+            }
+            sparse.push_back(std::move(row));
+        }
+    }
+
+    Node<T> *lca(const Node<T> &a, const Node<T> &b) const
+    {
+        if (!lca_valid)
+        {
+            throw std::runtime_error("LCA index is not built."); // Throw error if the index is stale
+        }
+        auto first_a = first_visit.find(&a);
+        auto first_b = first_visit.find(&b);
+        if (first_a == first_visit.end() || first_b == first_visit.end())
+        {
+            throw std::runtime_error("Node not found in LCA index."); // Throw error if a node is not in the tree
+        }
+        size_t left = std::min(first_a->second, first_b->second);
+        size_t right = std::max(first_a->second, first_b->second);
+        size_t level = log_table[right - left + 1]; // Largest power of two fitting in the range
+        size_t x = sparse[level][left];
+        size_t y = sparse[level][right - (size_t(1) << level) + 1];
+        return euler[euler_depth[x] <= euler_depth[y] ? x : y];
+    }
+
+    // Heavy-light decomposition with a segment tree over node values, for path aggregates
+    template <typename Op>
+    class path_index
+    {
+    public:
+        path_index(Tree &tree, Op op)
+            : op(op), tree(&tree), structure_seen(tree.structure_version), values_seen(tree.value_version)
+        {
+            Node<T> *root = tree.root;
+            if (!root)
+                return;
+
+            // Pre-order numbering with parents and depths
+            std::vector<Node<T> *> stack = {root};
+            while (!stack.empty())
+            {
+                Node<T> *node = stack.back();
+                stack.pop_back();
+                size_t id = nodes.size();
+                ids[node] = id;
+                nodes.push_back(node);
+                parent.push_back(node == root ? id : ids.at(node->get_parent()));
+                depth.push_back(node == root ? 0 : depth[parent[id]] + 1);
+                for (auto it = node->get_children().rbegin(); it != node->get_children().rend(); ++it)
+                {
+                    if (*it != nullptr)
+                        stack.push_back(*it); // Push children in reverse order
+                }
+            }
+
+            // Subtree sizes from the pre-order numbering, then the heaviest child of each node
+            size_t n = nodes.size();
+            std::vector<size_t> size(n, 1);
+            std::vector<size_t> heavy(n, n);
+            for (size_t id = n - 1; id > 0; --id)
+            {
+                size_t p = parent[id];
+                size[p] += size[id];
+                if (heavy[p] == n || size[id] > size[heavy[p]])
+                    heavy[p] = id;
+            }
+
+            // Lay out heavy chains contiguously
+            head.assign(n, 0);
+            pos.assign(n, 0);
+            std::vector<size_t> chain_stack = {0};
+            size_t next_pos = 0;
+            while (!chain_stack.empty())
+            {
+                size_t id = chain_stack.back();
+                chain_stack.pop_back();
+                pos[id] = next_pos++;
+                for (auto child : nodes[id]->get_children())
+                {
+                    if (child != nullptr && ids.at(child) != heavy[id])
+                    {
+                        head[ids.at(child)] = ids.at(child); // A light child starts its own chain
+                        chain_stack.push_back(ids.at(child));
+                    }
+                }
+                if (heavy[id] != n)
+                {
+                    head[heavy[id]] = head[id]; // The heavy child continues the chain and is placed next
+                    chain_stack.push_back(heavy[id]);
+                }
+            }
+
+            segment.resize(2 * n, root->get_value());
+            load_values();
+        }
+
+        T path_query(const Node<T> &a, const Node<T> &b) const
+        {
+            sync_with_tree();
+            size_t u = id_of(a);
+            size_t v = id_of(b);
+            T result = nodes[u]->get_value();
+            bool has_result = false;
+            while (head[u] != head[v])
+            {
+                if (depth[head[u]] < depth[head[v]])
+                    std::swap(u, v);
+                accumulate(result, has_result, range_query(pos[head[u]], pos[u] + 1));
+                u = parent[head[u]]; // Jump past the chain
+            }
+            if (pos[u] > pos[v])
+                std::swap(u, v);
+            accumulate(result, has_result, range_query(pos[u], pos[v] + 1));
+            return result;
+        }
+
+        void update(Node<T> &node, const T &value)
+        {
+            sync_with_tree();
+            size_t i = nodes.size() + pos[id_of(node)];
+            tree->set_value(node, value); // Keeps the tree's aggregates and hashes current
+            values_seen = tree->value_version;
+            segment[i] = value;
+            for (i /= 2; i > 0; i /= 2)
+                segment[i] = op(segment[2 * i], segment[2 * i + 1]); // Refresh the segment tree path
+        }
+
+    private:
+        Op op;                                         // Operation combined along paths
+        std::vector<Node<T> *> nodes;                  // Nodes by pre-order number
+        std::unordered_map<const Node<T> *, size_t> ids; // Pre-order number of each node
+        std::vector<size_t> parent;                    // Parent pre-order number, the root is its own parent
+        std::vector<size_t> depth;                     // Depth of each node
+        std::vector<size_t> head;                      // Top node of each node's heavy chain
+        std::vector<size_t> pos;                       // Position in the segment tree
+        mutable std::vector<T> segment;                // Bottom-up segment tree over positions
+        Tree *tree;                                    // Tree whose values this index mirrors
+        size_t structure_seen;                         // Tree structure version the index was built for
+        mutable size_t values_seen;                    // Tree value version the segment tree holds
+
+        // Throws once the tree's structure has changed, like lca, and reloads values changed
+        // through the tree or another index
+        void sync_with_tree() const
+        {
+            tree->settle(); // Concurrent inserts count as structural changes
+            if (structure_seen != tree->structure_version)
+            {
+                throw std::runtime_error("Path index is out of date."); // Rebuild after structural changes
+            }
+            if (values_seen != tree->value_version)
+            {
+                load_values();
+                values_seen = tree->value_version;
+            }
+        }
+
+        void load_values() const
+        {
+            size_t n = nodes.size();
+            for (size_t id = 0; id < n; ++id)
+                segment[n + pos[id]] = nodes[id]->get_value();
+            for (size_t i = n; i-- > 1;)
+                segment[i] = op(segment[2 * i], segment[2 * i + 1]);
+        }
+
+        size_t id_of(const Node<T> &node) const
+        {
+            auto it = ids.find(&node);
+            if (it == ids.end())
+            {
+                throw std::runtime_error("Node not found in path index."); // Throw error if the node is not in the tree
+            }
+            return it->second;
+        }
+
+        void accumulate(T &result, bool &has_result, const T &value) const
+        {
+            result = has_result ? op(result, value) : value;
+            has_result = true;
+        }
+
+        T range_query(size_t left, size_t right) const
+        {
+            size_t n = nodes.size();
+            T result = segment[n + left];
+            bool has_result = false;
+            for (left += n, right += n; left < right; left /= 2, right /= 2)
+            {
+                if (left & 1)
+                    accumulate(result, has_result, segment[left++]);
+                if (right & 1)
+                    accumulate(result, has_result, segment[--right]);
+            }
+            return result;
+        }
+    };
+
+    template <typename Op>
+    path_index<Op> build_path_index(Op op)
+    {
+        settle(); // The index records the structure version after concurrent inserts
+        return path_index<Op>(*this, op); // Index over the current structure, updated through this tree
+    }
+
+    // Immutable node of a published version, shared by every later version in which its subtree is unchanged
+    using published_node = typename PersistentTree<T>::node;
+
+    // A reader's handle on one published version. It pins the version until destroyed, so the writer can
+    // keep publishing and reclaiming older versions. Readers walk it through published_node, whose
+    // children hold no empty slots; copying their shared_ptrs is allowed but costs atomic refcount updates.
+    class snapshot
+    {
+    public:
+        snapshot(snapshot &&other) noexcept : slot(other.slot), root(other.root)
+        {
+            other.slot = nullptr;
+        }
+
+        snapshot(const snapshot &) = delete;
+        snapshot &operator=(const snapshot &) = delete;
+
+        ~snapshot()
+        {
+            if (slot)
+                slot->store(0, std::memory_order_release); // Every read of the version happens before this
+        }
+
+        const published_node *get_root() const
+        {
+            return root; // nullptr before the first publish or for an empty tree
+        }
+
+        size_t size() const
+        {
+            return get_root() ? get_root()->get_subtree_size() : 0; // Number of nodes in this version
+        }
+
+    private:
+        friend class Tree;
+
+        snapshot(std::atomic<uint64_t> &slot, const published_node *root) : slot(&slot), root(root) {}
+
+        std::atomic<uint64_t> *slot; // Reader slot announcing the epoch this handle was taken in
+        const published_node *root;  // Root of the version pinned by the slot
+    };
+
+    // Swaps in a new immutable version for readers. Only nodes changed since the last publish are copied;
+    // every other subtree is shared with the previous version, so a publish costs O(changed nodes + their
+    // children) rather than O(n). Call from the single writer thread, not alongside concurrent inserts.
+    // Changes made through Node directly, such as Node::set_value, are not tracked.
+    void publish()
+    {
+        settle(); // Folding concurrent inserts marks their parents unpublished
+        const version *next = new version{root ? build_published() : nullptr};
+        unpublished.clear();
+        const version *old = published.exchange(next); // Readers switch to the new version on their next load
+        if (old)
+            retired.emplace_back(old, epoch.fetch_add(1)); // Readers announcing a later epoch cannot load old
+        reclaim();
+    }
+
+    // Lock-free: the reader announces the current epoch in a free slot and loads the published pointer,
+    // without touching reference counts or locks. Slots are shared by all threads; with more than
+    // reader_slots handles alive at once, this waits until one is released.
+    snapshot current_snapshot() const
+    {
+        for (size_t i = thread_log() % reader_slots;; i = (i + 1) % reader_slots)
+        {
+            std::atomic<uint64_t> &slot = readers[i].epoch;
+            uint64_t idle = 0;
+            if (slot.load(std::memory_order_relaxed) != 0 || !slot.compare_exchange_strong(idle, epoch.load()))
+                continue; // Taken by another reader
+            const version *current = published.load(); // Announced first, so publish cannot free what is loaded
+            return snapshot(slot, current ? current->root.get() : nullptr);
+        }
+    }
+
     ~Tree()
     {
-        // No dynamic memory to delete
+        // Readers must have released their snapshots by now
+        delete published.load();
+        for (const auto &entry : retired)
+            delete entry.first;
     }
 
     // Pre-order iterator
     class pre_order_iterator
     {
     public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Node<T>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Node<T> *;
+        using reference = Node<T> &;
+
+        pre_order_iterator() : k(0) {} // End iterator, also used for default construction
+
         explicit pre_order_iterator(Node<T> *node, size_t k) : k(k)
         {
             if (node)
@@ -66,7 +935,13 @@ public:
 
         bool operator!=(const pre_order_iterator &other) const
         {
-            return !nodes.empty() != !other.nodes.empty(); // Check if nodes stack is not empty
+            // The visited node and the pending stack depth identify the position within a traversal
+            return position() != other.position() || nodes.size() != other.nodes.size();
+        }
+
+        bool operator==(const pre_order_iterator &other) const
+        {
+            return !(*this != other);
         }
 
         Node<T> *operator->() const
@@ -91,7 +966,19 @@ public:
             return *this;
         }
 
+        pre_order_iterator operator++(int)
+        {
+            pre_order_iterator previous = *this;
+            ++(*this);
+            return previous;
+        }
+
     private:
+        Node<T> *position() const
+        {
+            return nodes.empty() ? nullptr : nodes.top(); // Current node, nullptr at the end
+        }
+
         std::stack<Node<T> *> nodes; // Stack for nodes
         size_t k;                    // Maximum number of children
     };
@@ -110,25 +997,33 @@ public:
     class post_order_iterator
     {
     public:
-        explicit post_order_iterator(Node<T> *node, size_t k) : current(nullptr), k(k)
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Node<T>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Node<T> *;
+        using reference = Node<T> &;
+
+        post_order_iterator() : current(nullptr) {} // End iterator, also used for default construction
+
+        // The same walk serves every arity, so k is accepted for symmetry with the other iterators
+        explicit post_order_iterator(Node<T> *node, size_t) : current(nullptr)
         {
             if (node)
             {
-                if (k == 2)
-                {
-                    pushLeftmostPath(node); // Push leftmost path for binary trees
-                }
-                else
-                {
-                    nodes.push(node); // Push root node for general trees
-                }
+                nodes.push({node, 0}); // Start at the root with no children visited yet
             }
             ++(*this); // Move to the first valid node
         }
 
         bool operator!=(const post_order_iterator &other) const
         {
-            return current != other.current; // Check if current node is not the same as other's current node
+            // The visited node and the pending stack depth identify the position within a traversal
+            return current != other.current || nodes.size() != other.nodes.size();
+        }
+
+        bool operator==(const post_order_iterator &other) const
+        {
+            return !(*this != other);
         }
 
         Node<T> *operator->() const
@@ -143,81 +1038,40 @@ public:
 
         post_order_iterator &operator++()
         {
-            if (k == 2)
-            {
-                // Binary tree traversal
-                if (!nodes.empty())
-                {
-                    Node<T> *node = nodes.top();
-                    nodes.pop();
-
-                    // If the stack is not empty, check the parent node
-                    if (!nodes.empty())
-                    {
-                        Node<T> *parent = nodes.top();
-                        // If the current node is the left child, push the leftmost path of the right child
-                        if (parent->get_children().size() > 1 && node == parent->get_children()[0])
-                        {
-                            pushLeftmostPath(parent->get_children()[1]);
-                        }
-                    }
-                    // Update the current node to the node that was just popped
-                    current = node;
-                }
-                else
-                {
-                    // End iteration if stack is empty
-                    current = nullptr;
-                }
-            }
-            else
+            // Each stack entry is a node on the current path and the index of its next unvisited child,
+            // so every node is pushed and popped once and the stack never exceeds the tree depth
+            while (!nodes.empty())
             {
-                // General tree traversal
-                if (!nodes.empty())
+                auto &top = nodes.top();
+                const auto &children = top.first->get_children();
+                if (top.second < children.size())
                 {
-                    Node<T> *node = nodes.top();
-                    nodes.pop();
-
-                    // Push children of the current node in reverse order
-                    for (auto it = node->get_children().rbegin(); it != node->get_children().rend(); ++it)
+                    Node<T> *child = children[top.second++];
+                    if (child)
                     {
-                        if (*it)
-                        {
-                            nodes.push(*it);
-                        }
+                        nodes.push({child, 0}); // Descend before visiting the parent
                     }
-                    // Update the current node to the node that was just popped
-                    current = node;
-                }
-                else
-                {
-                    // End iteration if stack is empty
-                    current = nullptr;
+                    continue;
                 }
+                // All children are done, so the node itself comes next
+                current = top.first;
+                nodes.pop();
+                return *this;
             }
+            current = nullptr; // End iteration if stack is empty
             return *this;
         }
 
-    private:
-        std::stack<Node<T> *> nodes; // Stack for nodes
-        Node<T> *current;            // Current node
-        size_t k;                    // Maximum number of children
-
-        void pushLeftmostPath(Node<T> *node)
+        post_order_iterator operator++(int)
         {
-            while (node)
-            {
-                nodes.push(node);
-                if (!node->get_children().empty())
-                {
-                    node = node->get_children()[0]; // Push leftmost children
-                }
-                else
-                {
-                    break;
-                }
-            }
+            post_order_iterator previous = *this;
+            ++(*this);
+            return previous;
         }
+
+    private:
+        std::stack<std::pair<Node<T> *, size_t>> nodes; // Path from the root with the next child index of each node
+        Node<T> *current;                               // Current node
     };
 
     post_order_iterator begin_post_order() const
@@ -234,6 +1088,14 @@ public:
     class in_order_iterator
     {
     public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Node<T>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Node<T> *;
+        using reference = Node<T> &;
+
+        in_order_iterator() : k(0) {} // End iterator, also used for default construction
+
         explicit in_order_iterator(Node<T> *node, size_t k) : k(k)
         {
             if (node)
@@ -253,7 +1115,13 @@ public:
 
         bool operator!=(const in_order_iterator &other) const
         {
-            return !nodes.empty() != !other.nodes.empty(); // Check if nodes stack is not empty
+            // The visited node and the pending stack depth identify the position within a traversal
+            return position() != other.position() || nodes.size() != other.nodes.size();
+        }
+
+        bool operator==(const in_order_iterator &other) const
+        {
+            return !(*this != other);
         }
 
         Node<T> *operator->() const
@@ -293,7 +1161,19 @@ public:
             return *this;
         }
 
+        in_order_iterator operator++(int)
+        {
+            in_order_iterator previous = *this;
+            ++(*this);
+            return previous;
+        }
+
     private:
+        Node<T> *position() const
+        {
+            return nodes.empty() ? nullptr : nodes.top(); // Current node, nullptr at the end
+        }
+
         std::stack<Node<T> *> nodes; // Stack for nodes
         size_t k;                    // Maximum number of children
 
@@ -320,10 +1200,137 @@ public:
         return in_order_iterator(nullptr, k); // Return iterator at end
     }
 
+    // K-ary in-order: each node is visited after the subtrees in its first split child slots and before the rest.
+    // Walks parent pointers, so it allocates nothing; split 0 gives pre-order and split >= k gives post-order.
+    class split_in_order_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Node<T>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Node<T> *;
+        using reference = Node<T> &;
+
+        split_in_order_iterator() : top(nullptr), current(nullptr), split(0) {} // End iterator, also used for default construction
+
+        explicit split_in_order_iterator(Node<T> *node, size_t split) : top(node), current(nullptr), split(split)
+        {
+            if (node)
+                current = first(node);
+        }
+
+        bool operator!=(const split_in_order_iterator &other) const
+        {
+            return current != other.current; // Each node is visited once, so it identifies the position
+        }
+
+        bool operator==(const split_in_order_iterator &other) const
+        {
+            return !(*this != other);
+        }
+
+        Node<T> *operator->() const
+        {
+            return current; // Return current node
+        }
+
+        Node<T> &operator*() const
+        {
+            return *current; // Dereference current node
+        }
+
+        split_in_order_iterator &operator++()
+        {
+            if (!current)
+                return *this;
+
+            Node<T> *right = child_from(current, split, current->get_children().size());
+            if (right)
+            {
+                current = first(right); // Continue with the subtrees after the split
+                return *this;
+            }
+
+            // The subtree of node is finished, climb until an ancestor has work left
+            Node<T> *node = current;
+            while (node != top)
+            {
+                Node<T> *parent = node->get_parent();
+                const auto &children = parent->get_children();
+                size_t index = std::find(children.begin(), children.end(), node) - children.begin();
+                if (index < split)
+                {
+                    Node<T> *next = child_from(parent, index + 1, split);
+                    current = next ? first(next) : parent; // The parent follows its left subtrees
+                    return *this;
+                }
+                Node<T> *next = child_from(parent, index + 1, children.size());
+                if (next)
+                {
+                    current = first(next);
+                    return *this;
+                }
+                node = parent;
+            }
+            current = nullptr; // End iteration once the starting node's subtree is done
+            return *this;
+        }
+
+        split_in_order_iterator operator++(int)
+        {
+            split_in_order_iterator previous = *this;
+            ++(*this);
+            return previous;
+        }
+
+    private:
+        Node<T> *top;     // Root of the traversed subtree
+        Node<T> *current; // Current node
+        size_t split;     // Number of child slots visited before the node
+
+        // First non-null child in slots [from, to)
+        static Node<T> *child_from(Node<T> *node, size_t from, size_t to)
+        {
+            const auto &children = node->get_children();
+            for (size_t i = from; i < std::min(to, children.size()); ++i)
+            {
+                if (children[i])
+                    return children[i];
+            }
+            return nullptr;
+        }
+
+        // First node visited within the subtree of node
+        Node<T> *first(Node<T> *node) const
+        {
+            while (Node<T> *left = child_from(node, 0, split))
+                node = left;
+            return node;
+        }
+    };
+
+    split_in_order_iterator begin_in_order(size_t split) const
+    {
+        return split_in_order_iterator(root, split); // Return iterator starting at root
+    }
+
+    split_in_order_iterator end_in_order(size_t) const
+    {
+        return split_in_order_iterator(); // Return iterator at end
+    }
+
     // BFS iterator
     class bfs_iterator
     {
     public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Node<T>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Node<T> *;
+        using reference = Node<T> &;
+
+        bfs_iterator() {} // End iterator, also used for default construction
+
         explicit bfs_iterator(Node<T> *node)
         {
             if (node)
@@ -332,7 +1339,13 @@ public:
 
         bool operator!=(const bfs_iterator &other) const
         {
-            return !nodes.empty() != !other.nodes.empty(); // Check if nodes queue is not empty
+            // The visited node and the queue length identify the position within a traversal
+            return position() != other.position() || nodes.size() != other.nodes.size();
+        }
+
+        bool operator==(const bfs_iterator &other) const
+        {
+            return !(*this != other);
         }
 
         Node<T> *operator->() const
@@ -358,86 +1371,315 @@ public:
             return *this;
         }
 
-    private:
-        std::queue<Node<T> *> nodes; // Queue for nodes
-    };
+        bfs_iterator operator++(int)
+        {
+            bfs_iterator previous = *this;
+            ++(*this);
+            return previous;
+        }
+
+    private:
+        Node<T> *position() const
+        {
+            return nodes.empty() ? nullptr : nodes.front(); // Current node, nullptr at the end
+        }
+
+        std::queue<Node<T> *> nodes; // Queue for nodes
+    };
+
+    bfs_iterator begin_bfs_scan() const
+    {
+        return bfs_iterator(root); // Return iterator starting at root
+    }
+
+    bfs_iterator end_bfs_scan() const
+    {
+        return bfs_iterator(nullptr); // Return iterator at end
+    }
+
+    // DFS iterator
+    class dfs_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Node<T>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Node<T> *;
+        using reference = Node<T> &;
+
+        dfs_iterator() {} // End iterator, also used for default construction
+
+        explicit dfs_iterator(Node<T> *node)
+        {
+            if (node)
+                nodes.push(node); // Initialize with root node
+        }
+
+        bool operator!=(const dfs_iterator &other) const
+        {
+            // The visited node and the pending stack depth identify the position within a traversal
+            return position() != other.position() || nodes.size() != other.nodes.size();
+        }
+
+        bool operator==(const dfs_iterator &other) const
+        {
+            return !(*this != other);
+        }
+
+        Node<T> *operator->() const
+        {
+            return nodes.top(); // Return top node in stack
+        }
+
+        Node<T> &operator*() const
+        {
+            return *nodes.top(); // Dereference top node in stack
+        }
+
+        dfs_iterator &operator++()
+        {
+            Node<T> *current = nodes.top();
+            nodes.pop();
+            // in this for loop, we push the children in reverse order
+            for (auto it = current->get_children().rbegin(); it != current->get_children().rend(); ++it)
+            {
+                if (*it != nullptr)
+                    nodes.push(*it); // Push children in reverse order
+            }
+            return *this;
+        }
+
+        dfs_iterator operator++(int)
+        {
+            dfs_iterator previous = *this;
+            ++(*this);
+            return previous;
+        }
+
+    private:
+        Node<T> *position() const
+        {
+            return nodes.empty() ? nullptr : nodes.top(); // Current node, nullptr at the end
+        }
+
+        std::stack<Node<T> *> nodes; // Stack for nodes
+    };
+
+    dfs_iterator begin_dfs_scan() const
+    {
+        return dfs_iterator(root); // Return iterator starting at root
+    }
+
+    dfs_iterator end_dfs_scan() const
+    {
+        return dfs_iterator(nullptr); // Return iterator at end
+    }
+
+    bfs_iterator begin() const
+    {
+        return bfs_iterator(root); // Default iterator is BFS starting at root
+    }
+
+    bfs_iterator end() const
+    {
+        return bfs_iterator(nullptr); // Default iterator at end
+    }
+
+    // A lazy [begin, end) pair over one traversal order, usable with range-for and <algorithm>
+    template <typename Iterator>
+    class traversal
+    {
+    public:
+        using iterator = Iterator;
+
+        traversal(Iterator first, Iterator last) : first(first), last(last) {}
+
+        Iterator begin() const
+        {
+            return first; // Copy of the starting position
+        }
+
+        Iterator end() const
+        {
+            return last; // Copy of the end position
+        }
+
+        // Splits the range into consecutive sub-ranges of up to chunk_size nodes, for processing in parallel
+        std::vector<traversal> chunks(size_t chunk_size) const
+        {
+            if (chunk_size == 0)
+            {
+                throw std::invalid_argument("Chunk size must be positive."); // Throw error on an empty chunk size
+            }
+            std::vector<traversal> result;
+            Iterator chunk_begin = first;
+            Iterator it = first;
+            size_t count = 0;
+            while (it != last)
+            {
+                ++it;
+                if (++count == chunk_size)
+                {
+                    result.emplace_back(chunk_begin, it); // One walk finds every boundary
+                    chunk_begin = it;
+                    count = 0;
+                }
+            }
+            if (count > 0)
+                result.emplace_back(chunk_begin, last);
+            return result;
+        }
+
+    private:
+        Iterator first; // Starting position
+        Iterator last;  // End position
+    };
+
+    traversal<pre_order_iterator> pre_order() const
+    {
+        return traversal<pre_order_iterator>(begin_pre_order(), end_pre_order());
+    }
+
+    traversal<post_order_iterator> post_order() const
+    {
+        return traversal<post_order_iterator>(begin_post_order(), end_post_order());
+    }
+
+    traversal<in_order_iterator> in_order() const
+    {
+        return traversal<in_order_iterator>(begin_in_order(), end_in_order());
+    }
+
+    traversal<split_in_order_iterator> in_order(size_t split) const
+    {
+        return traversal<split_in_order_iterator>(begin_in_order(split), end_in_order(split));
+    }
 
-    bfs_iterator begin_bfs_scan() const
+    traversal<bfs_iterator> bfs() const
     {
-        return bfs_iterator(root); // Return iterator starting at root
+        return traversal<bfs_iterator>(begin_bfs_scan(), end_bfs_scan());
     }
 
-    bfs_iterator end_bfs_scan() const
+    traversal<dfs_iterator> dfs() const
     {
-        return bfs_iterator(nullptr); // Return iterator at end
+        return traversal<dfs_iterator>(begin_dfs_scan(), end_dfs_scan());
     }
 
-    // DFS iterator
-    class dfs_iterator
+    enum class walk_order
+    {
+        pre_order,
+        post_order,
+        in_order,
+        bfs,
+        dfs
+    };
+
+    // Resumable traversal that owns its own state; it can be paused between nodes and resumed later
+    class walker
     {
     public:
-        explicit dfs_iterator(Node<T> *node)
-        {
-            if (node)
-                nodes.push(node); // Initialize with root node
-        }
+        template <typename Iterator>
+        walker(Iterator first, Iterator last) : state(position<Iterator>{first, last}) {}
 
-        bool operator!=(const dfs_iterator &other) const
+        bool done() const
         {
-            return !nodes.empty() != !other.nodes.empty(); // Check if nodes stack is not empty
+            return std::visit([](const auto &walk)
+                              { return walk.current == walk.last; },
+                              state); // Finished once the traversal reaches its end
         }
 
-        Node<T> *operator->() const
+        Node<T> *next()
         {
-            return nodes.top(); // Return top node in stack
+            return std::visit([](auto &walk) -> Node<T> *
+                              {
+                if (walk.current == walk.last)
+                    return nullptr; // Nothing left to yield
+                Node<T> *node = &*walk.current;
+                ++walk.current;
+                return node; },
+                              state);
         }
 
-        Node<T> &operator*() const
+        template <typename Visitor>
+        size_t resume(size_t budget, Visitor visitor)
         {
-            return *nodes.top(); // Dereference top node in stack
+            return std::visit([&](auto &walk)
+                              {
+                size_t visited = 0;
+                for (; visited < budget && walk.current != walk.last; ++visited, ++walk.current)
+                    visitor(*walk.current); // Yield up to budget nodes, then suspend
+                return visited; },
+                              state);
         }
 
-        dfs_iterator &operator++()
+    private:
+        template <typename Iterator>
+        struct position
         {
-            Node<T> *current = nodes.top();
-            nodes.pop();
-            // in this for loop, we push the children in reverse order
-            for (auto it = current->get_children().rbegin(); it != current->get_children().rend(); ++it)
-            {
-                if (*it != nullptr)
-                    nodes.push(*it); // Push children in reverse order
-            }
-            return *this;
-        }
+            Iterator current; // Next node to yield
+            Iterator last;    // End of the traversal
+        };
 
-    private:
-        std::stack<Node<T> *> nodes; // Stack for nodes
+        std::variant<position<pre_order_iterator>, position<post_order_iterator>, position<in_order_iterator>,
+                     position<bfs_iterator>, position<dfs_iterator>>
+            state; // Suspended traversal of the chosen order
     };
 
-    dfs_iterator begin_dfs_scan() const
-    {
-        return dfs_iterator(root); // Return iterator starting at root
-    }
-
-    dfs_iterator end_dfs_scan() const
-    {
-        return dfs_iterator(nullptr); // Return iterator at end
-    }
-
-    bfs_iterator begin() const
+    walker walk(walk_order order) const
     {
-        return bfs_iterator(root); // Default iterator is BFS starting at root
+        switch (order)
+        {
+        case walk_order::pre_order:
+            return walker(begin_pre_order(), end_pre_order());
+        case walk_order::post_order:
+            return walker(begin_post_order(), end_post_order());
+        case walk_order::in_order:
+            return walker(begin_in_order(), end_in_order());
+        case walk_order::bfs:
+            return walker(begin_bfs_scan(), end_bfs_scan());
+        default:
+            return walker(begin_dfs_scan(), end_dfs_scan());
+        }
     }
 
-    bfs_iterator end() const
+    // Pruned pre-order walk: subtrees whose root fails descend are skipped whole, and a false
+    // return from visitor stops the walk. Returns whether every admitted node was visited.
+    template <typename Descend, typename Visitor>
+    bool visit(Descend descend, Visitor visitor) const
     {
-        return bfs_iterator(nullptr); // Default iterator at end
+        std::vector<Node<T> *> pending;
+        if (root)
+            pending.push_back(root);
+        while (!pending.empty())
+        {
+            Node<T> *current = pending.back();
+            pending.pop_back();
+            if (!descend(static_cast<const Node<T> &>(*current)))
+                continue; // Nothing below can match, never push its children
+            if (!visitor(*current))
+                return false; // Stop globally
+            const auto &children = current->get_children();
+            for (auto it = children.rbegin(); it != children.rend(); ++it)
+            {
+                if (*it)
+                    pending.push_back(*it);
+            }
+        }
+        return true;
     }
 
     // Heap iterator
     class heap_iterator
     {
     public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Node<T>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Node<T> *;
+        using reference = Node<T> &;
+
+        heap_iterator() : k(2) {} // End iterator, also used for default construction
+
         explicit heap_iterator(Node<T> *node, size_t k) : k(k)
         {
             if (k != 2)
@@ -453,29 +1695,44 @@ public:
 
         bool operator!=(const heap_iterator &other) const
         {
-            return !heap_nodes.empty() != !other.heap_nodes.empty(); // Check if heap is not empty
+            // The smallest remaining node and the remaining count identify the position
+            Node<T> *mine = heap_nodes.empty() ? nullptr : top();
+            Node<T> *theirs = other.heap_nodes.empty() ? nullptr : other.top();
+            return mine != theirs || heap_nodes.size() != other.heap_nodes.size();
+        }
+
+        bool operator==(const heap_iterator &other) const
+        {
+            return !(*this != other);
         }
 
         Node<T> *operator->() const
         {
-            return heap_nodes.front(); // Return front node in heap
+            return top(); // Return smallest remaining node
         }
 
         Node<T> &operator*() const
         {
-            return *heap_nodes.front(); // Dereference front node in heap
+            return *top(); // Dereference smallest remaining node
         }
 
         heap_iterator &operator++()
         {
             if (!heap_nodes.empty())
             {
-                std::pop_heap(heap_nodes.begin(), heap_nodes.end(), CompareNodes()); // Remove front node
+                std::pop_heap(heap_nodes.begin(), heap_nodes.end(), CompareNodes()); // Move front node to the back
                 heap_nodes.pop_back();
             }
             return *this;
         }
 
+        heap_iterator operator++(int)
+        {
+            heap_iterator previous = *this;
+            ++(*this);
+            return previous;
+        }
+
     private:
         struct CompareNodes
         {
@@ -497,6 +1754,11 @@ public:
             }
         }
 
+        Node<T> *top() const
+        {
+            return heap_nodes.front(); // Smallest remaining node is at the front of the heap
+        }
+
         std::vector<Node<T> *> heap_nodes; // Vector for heap nodes
         size_t k;                          // Maximum number of children
     };
@@ -511,6 +1773,36 @@ public:
         return heap_iterator(nullptr, k); // Return heap iterator at end
     }
 
+    traversal<heap_iterator> heap() const
+    {
+        return traversal<heap_iterator>(myHeap(), end_heap());
+    }
+
+    std::vector<T> top_k(size_t count) const
+    {
+        std::vector<T> values;
+        for (auto node = begin_pre_order(); node != end_pre_order(); ++node)
+            values.push_back(node->get_value()); // Gather every value once
+        count = std::min(count, values.size());
+        if constexpr (std::is_same<T, Complex>::value)
+        {
+            // Quickselect over the vectorized partition wins once k is about an eighth of n or more;
+            // below that a heap-based partial sort rejects most values with a single comparison
+            if (count * 8 >= values.size())
+            {
+                ComplexBatch batch(values);
+                std::vector<T> result;
+                for (size_t index : batch.smallest(count))
+                    result.push_back(values[index]);
+                return result;
+            }
+        }
+        std::partial_sort(values.begin(), values.begin() + count, values.end(), [](const T &a, const T &b)
+                          { return a < b; });
+        values.resize(count);
+        return values;
+    }
+
     friend std::ostream &operator<<(std::ostream &os, const Tree &tree)
     {
         if (!tree.root)
@@ -551,6 +1843,26 @@ public:
 
         position_nodes(tree.root, window.getSize().x / 2.f, node_radius + 50.f, initial_horizontal_spacing);
 
+        // Format every label once instead of on each frame
+        std::map<Node<T> *, std::string> labels;
+        for (const auto &pair : positions)
+        {
+            if constexpr (std::is_same<T, std::string>::value)
+            {
+                labels[pair.first] = pair.first->get_value();
+            }
+            else if constexpr (std::is_same<T, Complex>::value)
+            {
+                char buffer[64];
+                auto result = to_chars(buffer, buffer + sizeof(buffer), pair.first->get_value(), std::chars_format::general, 6);
+                labels[pair.first] = std::string(buffer, result.ptr); // Same text as operator<<, without a stream
+            }
+            else
+            {
+                labels[pair.first] = std::to_string(pair.first->get_value());
+            }
+        }
+
         while (window.isOpen())
         {
             sf::Event event;
@@ -574,20 +1886,7 @@ public:
 
                 sf::Text text;
                 text.setFont(font);
-                if constexpr (std::is_same<T, std::string>::value)
-                {
-                    text.setString(node->get_value());
-                }
-                else if constexpr (std::is_same<T, Complex>::value)
-                {
-                    std::ostringstream oss;
-                    oss << node->get_value();
-                    text.setString(oss.str());
-                }
-                else
-                {
-                    text.setString(std::to_string(node->get_value()));
-                }
+                text.setString(labels[node]);
                 text.setCharacterSize(16); // Slightly larger text size
                 text.setFillColor(sf::Color::Black);
                 sf::FloatRect text_bounds = text.getLocalBounds();
@@ -619,27 +1918,512 @@ private:
     Node<T> *root; // Root node of the tree
     size_t k;      // Maximum number of children
 
-    static void flatten_to_vector(Node<T> *node, std::vector<Node<T> *> &result)
+    mutable std::atomic<bool> lca_valid;                 // Whether the LCA index matches the current structure
+    mutable std::atomic<size_t> structure_version{0};    // Bumped on every structural change, checked by path indexes
+    size_t value_version = 0;                            // Bumped by set_value, so path indexes reload values
+    std::vector<Node<T> *> euler;                        // Euler tour of the tree
+    std::vector<size_t> euler_depth;                     // Depth of each Euler tour entry
+    std::unordered_map<const Node<T> *, size_t> first_visit; // First Euler tour position of each node
+    std::unordered_map<const Node<T> *, size_t> entry_time;  // DFS entry time of each node
+    std::unordered_map<const Node<T> *, size_t> exit_time;   // DFS exit time of each node
+    std::vector<std::vector<size_t>> sparse;             // Sparse table of minimum-depth tour positions
+    std::vector<size_t> log_table;                       // Floor of log2 for sparse table lookups
+
+    std::function<T(const T &, const T &)> aggregate_op; // Commutative monoid folded over each subtree
+    mutable std::unordered_map<const Node<T> *, T> aggregates; // Cached aggregate of each subtree
+
+    void fold_into_ancestors(Node<T> *parent, Node<T> *child)
     {
-        if (!node)
+        T added = compute_aggregate(child);
+        for (Node<T> *current = parent; current != nullptr; current = current->get_parent())
+        {
+            T &cached = aggregates.at(current);
+            cached = aggregate_op(cached, added); // Fold the new subtree into each ancestor
+        }
+    }
+
+    std::deque<Node<T>> pool;                  // Nodes created by insert, owned by the tree
+    std::unordered_set<const Node<T> *> pooled; // Addresses of the nodes in pool
+    std::vector<Node<T> *> free_nodes;          // Pool nodes recycled by remove_subtree
+
+    bool hashing = false;                                        // Whether subtree hashes are maintained
+    std::function<uint64_t(const T &)> value_hash;               // std::hash<T>, bound by enable_hashing
+    mutable std::unordered_map<const Node<T> *, uint64_t> hashes; // Merkle hash of each subtree
+
+    // Links made by add_sub_node_concurrent and not yet folded into sizes and caches. Each thread
+    // appends to its own log, so concurrent inserts share no counters, caches or locks.
+    struct alignas(64) pending_log
+    {
+        std::mutex lock;
+        std::vector<std::pair<Node<T> *, size_t>> links; // Linked child and its subtree size when linked
+    };
+    static constexpr size_t pending_logs = 32;            // Threads beyond this share logs
+    mutable std::array<pending_log, pending_logs> pending;
+    mutable std::atomic<bool> has_pending{false};         // Whether any log holds links
+    mutable std::mutex fold_mutex;                        // Serializes folding, which readers may start at once
+
+    static uint64_t mix(uint64_t h)
+    {
+        h ^= h >> 30; // splitmix64 finalizer
+        h *= 0xbf58476d1ce4e5b9ULL;
+        h ^= h >> 27;
+        h *= 0x94d049bb133111ebULL;
+        return h ^ (h >> 31);
+    }
+
+    // Combines the node's value with its child hashes in slot order; trailing empty slots do not count
+    uint64_t hash_node(const Node<T> *node) const
+    {
+        const auto &children = node->get_children();
+        size_t used = children.size();
+        while (used > 0 && !children[used - 1])
+            --used;
+        uint64_t h = mix(value_hash(node->get_value()));
+        for (size_t i = 0; i < used; ++i)
+        {
+            uint64_t child = children[i] ? hashes.at(children[i]) : 0x9e3779b97f4a7c15ULL; // Marker for an empty slot
+            h = mix(h ^ (child + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2)));
+        }
+        return h;
+    }
+
+    void hash_subtree(const Node<T> *node) const
+    {
+        std::vector<std::pair<const Node<T> *, size_t>> stack = {{node, 0}};
+        while (!stack.empty())
+        {
+            const Node<T> *current = stack.back().first;
+            size_t &next = stack.back().second;
+            const auto &children = current->get_children();
+            if (next < children.size())
+            {
+                Node<T> *child = children[next++];
+                if (child)
+                    stack.emplace_back(child, 0);
+            }
+            else
+            {
+                hashes[current] = hash_node(current); // All children are hashed, hash this node
+                stack.pop_back();
+            }
+        }
+    }
+
+    // Hashes a newly attached subtree, if any, then rehashes the path from parent to the root
+    void rehash_from(Node<T> *parent, Node<T> *added)
+    {
+        if (added)
+            hash_subtree(added);
+        for (Node<T> *current = parent; current != nullptr; current = current->get_parent())
+            hashes[current] = hash_node(current);
+    }
+
+    // An immutable version for readers; its nodes are shared with other versions through reference counts
+    struct version
+    {
+        std::shared_ptr<const published_node> root;
+    };
+    std::atomic<const version *> published{nullptr};              // Latest version, swapped in by publish
+    std::vector<std::pair<const version *, uint64_t>> retired;    // Replaced version and the epoch it was retired in
+    mutable std::atomic<uint64_t> epoch{1};                       // Advanced by every publish; 0 marks an idle slot
+    struct alignas(64) reader_slot
+    {
+        std::atomic<uint64_t> epoch{0}; // Epoch announced by the reader holding this slot
+    };
+    static constexpr size_t reader_slots = 32;                    // Snapshot handles that can be held at once
+    mutable std::array<reader_slot, reader_slots> readers;
+    std::unordered_map<const Node<T> *, std::shared_ptr<const published_node>> published_nodes; // Last published copy of each node
+    mutable std::unordered_set<const Node<T> *> unpublished;      // Changed since the last publish, with their ancestors
+
+    // Marks node and its ancestors for copying on the next publish. An already marked node has its
+    // ancestors marked, because every change marks the new parent's path as well.
+    void mark_unpublished(const Node<T> *node) const
+    {
+        if (published_nodes.empty())
+            return; // Nothing published yet, so the next publish copies everything
+        for (const Node<T> *current = node; current != nullptr && unpublished.insert(current).second;)
+            current = current->get_parent();
+    }
+
+    // Copies the unpublished nodes bottom-up and reuses the last published node of every other subtree
+    std::shared_ptr<const published_node> build_published()
+    {
+        auto stale = [&](const Node<T> *node)
+        { return unpublished.count(node) != 0 || published_nodes.count(node) == 0; };
+        std::vector<std::pair<Node<T> *, size_t>> stack;
+        if (stale(root))
+            stack.emplace_back(root, 0);
+        while (!stack.empty())
+        {
+            Node<T> *current = stack.back().first;
+            size_t &next = stack.back().second;
+            const auto &children = current->get_children();
+            if (next < children.size())
+            {
+                Node<T> *child = children[next++];
+                if (child && stale(child))
+                    stack.emplace_back(child, 0); // Unchanged children are not visited
+                continue;
+            }
+            stack.pop_back();
+
+            std::vector<std::shared_ptr<const published_node>> copies;
+            copies.reserve(children.size());
+            for (Node<T> *child : children)
+            {
+                if (child)
+                    copies.push_back(published_nodes.at(child)); // Empty slots are left out
+            }
+            published_nodes.insert_or_assign(current, std::make_shared<const published_node>(current->get_value(), std::move(copies)));
+        }
+        return published_nodes.at(root);
+    }
+
+    // Frees the retired versions that no reader can still hold: a reader that announced an epoch after
+    // a version was retired loaded the pointer after it was replaced
+    void reclaim()
+    {
+        uint64_t oldest = UINT64_MAX;
+        for (const reader_slot &reader : readers)
+        {
+            uint64_t announced = reader.epoch.load();
+            if (announced != 0 && announced < oldest)
+                oldest = announced;
+        }
+        size_t kept = 0;
+        for (const auto &entry : retired)
+        {
+            if (entry.second < oldest)
+                delete entry.first; // Every reader that could see it has released its slot
+            else
+                retired[kept++] = entry;
+        }
+        retired.resize(kept);
+    }
+
+    static size_t thread_log()
+    {
+        static std::atomic<size_t> next_log{0};
+        thread_local size_t log = next_log++ % pending_logs; // Threads take logs in turn
+        return log;
+    }
+
+    // Applies the logged links: each size goes up its ancestor path, each new subtree is cached
+    // whole from its topmost link, and then every ancestor above those is refolded and rehashed once,
+    // after its children
+    void fold_pending() const
+    {
+        std::lock_guard<std::mutex> guard(fold_mutex);
+        if (!has_pending)
+            return; // Another reader folded first
+        std::vector<std::pair<Node<T> *, size_t>> links;
+        for (pending_log &log : pending)
+        {
+            std::lock_guard<std::mutex> log_guard(log.lock);
+            links.insert(links.end(), log.links.begin(), log.links.end());
+            log.links.clear();
+        }
+        has_pending = false;
+        lca_valid = false;   // Drop the LCA index
+        ++structure_version; // Path indexes built before the inserts throw
+
+        for (const auto &link : links)
+        {
+            link.first->get_parent()->add_to_subtree_sizes(link.second);
+            mark_unpublished(link.first->get_parent());
+        }
+        if (!aggregate_op && !hashing)
             return;
-        result.push_back(node); // Add current node to result
+
+        // A link under an uncached parent lies inside another new subtree, which covers it
+        auto cached = [&](Node<T> *node)
+        { return aggregate_op ? aggregates.count(node) != 0 : hashes.count(node) != 0; };
+        std::vector<Node<T> *> tops;
+        for (const auto &link : links)
+        {
+            if (cached(link.first->get_parent()))
+                tops.push_back(link.first);
+        }
+
+        std::unordered_map<Node<T> *, size_t> waiting; // Ancestor and its number of ancestors below still to refold
+        for (Node<T> *top : tops)
+        {
+            if (aggregate_op)
+                compute_aggregate(top);
+            if (hashing)
+                hash_subtree(top);
+            Node<T> *below = nullptr;
+            for (Node<T> *current = top->get_parent(); current != nullptr; current = current->get_parent())
+            {
+                auto entry = waiting.emplace(current, 0);
+                if (below)
+                    ++entry.first->second;
+                if (!entry.second)
+                    break; // The path above was marked by an earlier link
+                below = current;
+            }
+        }
+
+        std::vector<Node<T> *> ready;
+        for (const auto &entry : waiting)
+        {
+            if (entry.second == 0)
+                ready.push_back(entry.first);
+        }
+        while (!ready.empty())
+        {
+            Node<T> *current = ready.back();
+            ready.pop_back();
+            if (aggregate_op)
+                aggregates.insert_or_assign(current, fold_children(current));
+            if (hashing)
+                hashes[current] = hash_node(current);
+            auto parent = waiting.find(current->get_parent());
+            if (parent != waiting.end() && --parent->second == 0)
+                ready.push_back(parent->first);
+        }
+    }
+
+    // Walks both trees in parallel, skipping subtrees with equal hashes, and reports each pair of
+    // nodes at the same position whose own values differ, or where one side has no node
+    template <typename Report>
+    void walk_differences(const Tree &other, Report report) const
+    {
+        bool use_hashes = hashing && other.hashing;
+        std::vector<std::pair<Node<T> *, Node<T> *>> stack = {{root, other.root}};
+        while (!stack.empty())
+        {
+            auto [mine, theirs] = stack.back();
+            stack.pop_back();
+            if (!mine && !theirs)
+                continue;
+            if (!mine || !theirs)
+            {
+                if (!report(mine, theirs))
+                    return;
+                continue;
+            }
+            if (use_hashes && hashes.at(mine) == other.hashes.at(theirs))
+                continue; // Identical subtrees, nothing below can differ
+            if (!(mine->get_value() == theirs->get_value()) && !report(mine, theirs))
+                return;
+            const auto &a = mine->get_children();
+            const auto &b = theirs->get_children();
+            for (size_t i = std::max(a.size(), b.size()); i-- > 0;)
+                stack.emplace_back(i < a.size() ? a[i] : nullptr, i < b.size() ? b[i] : nullptr);
+        }
+    }
+
+    // Copies other's nodes bottom-up, so each link updates only the new parent's subtree size
+    Node<T> *clone(const Tree &other)
+    {
+        if (!other.root)
+            return nullptr;
+        std::vector<std::pair<Node<T> *, size_t>> stack = {{other.root, 0}};
+        std::vector<Node<T> *> built; // Copies of finished subtrees, children of the same parent in order
+        while (!stack.empty())
+        {
+            Node<T> *current = stack.back().first;
+            size_t &next = stack.back().second;
+            const auto &children = current->get_children();
+            if (next < children.size())
+            {
+                Node<T> *child = children[next++];
+                if (child)
+                    stack.emplace_back(child, 0);
+                continue;
+            }
+            stack.pop_back();
+
+            Node<T> *copy = allocate(current->get_value());
+            size_t first = built.size() - count_children(current);
+            size_t taken = first;
+            for (Node<T> *child : children)
+            {
+                if (child)
+                    copy->add_child(built[taken++], k);
+                else
+                    copy->add_empty_slot(k); // Keep empty slots, such as a missing left child
+            }
+            built.resize(first);
+            built.push_back(copy);
+            if (aggregate_op)
+                aggregates.insert_or_assign(copy, other.aggregates.at(current));
+            if (hashing)
+                hashes[copy] = other.hashes.at(current);
+        }
+        return built.back();
+    }
+
+    static size_t count_children(const Node<T> *node)
+    {
+        const auto &children = node->get_children();
+        return children.size() - std::count(children.begin(), children.end(), nullptr);
+    }
+
+    void take(Tree &other)
+    {
+        root = other.root;
+        k = other.k;
+        lca_valid = other.lca_valid.load();
+        euler = std::move(other.euler);
+        euler_depth = std::move(other.euler_depth);
+        first_visit = std::move(other.first_visit);
+        entry_time = std::move(other.entry_time);
+        exit_time = std::move(other.exit_time);
+        sparse = std::move(other.sparse);
+        log_table = std::move(other.log_table);
+        aggregate_op = std::move(other.aggregate_op);
+        aggregates = std::move(other.aggregates);
+        for (const auto &entry : retired)
+            delete entry.first; // No reader may hold a snapshot of either tree while it is moved
+        retired = std::move(other.retired);
+        delete published.exchange(other.published.exchange(nullptr));
+        epoch = std::max(epoch.load(), other.epoch.load()); // Later than every retired version's epoch
+        published_nodes = std::move(other.published_nodes);
+        unpublished = std::move(other.unpublished);
+        pool = std::move(other.pool); // A moved deque keeps its elements in place
+        pooled = std::move(other.pooled);
+        free_nodes = std::move(other.free_nodes);
+        hashing = other.hashing;
+        value_hash = std::move(other.value_hash);
+        hashes = std::move(other.hashes);
+        for (size_t i = 0; i < pending_logs; ++i)
+        {
+            pending[i].links.swap(other.pending[i].links); // Unfolded links move with their nodes
+            other.pending[i].links.clear();
+        }
+        has_pending = other.has_pending.load();
+        other.has_pending = false;
+
+        ++structure_version; // Path indexes built on either tree no longer match it
+        ++other.structure_version;
+        other.root = nullptr; // Leave other as a valid empty tree
+        other.lca_valid = false;
+        other.aggregate_op = nullptr;
+        other.aggregates.clear();
+        other.pool.clear();
+        other.pooled.clear();
+        other.free_nodes.clear();
+        other.hashing = false;
+        other.value_hash = nullptr;
+        other.hashes.clear();
+        other.retired.clear();
+        other.published_nodes.clear();
+        other.unpublished.clear();
+    }
+
+    // Brings sizes and caches up to date with concurrent inserts, so a sequential change can update
+    // them incrementally. Must not overlap with add_sub_node_concurrent.
+    void settle() const
+    {
+        if (has_pending.load(std::memory_order_acquire))
+            fold_pending();
+    }
+
+    void structure_changed()
+    {
+        lca_valid = false;   // Drop the LCA index
+        ++structure_version; // Path indexes built before now throw
+    }
+
+    bool contains(const Node<T> &node) const
+    {
+        const Node<T> *top = &node;
+        while (top->get_parent())
+            top = top->get_parent(); // Climb to the root of whatever tree holds the node
+        return root && top == root;
+    }
+
+    Node<T> *allocate(const T &value)
+    {
+        if (!free_nodes.empty())
+        {
+            Node<T> *node = free_nodes.back(); // Reuse recycled storage before growing the pool
+            free_nodes.pop_back();
+            node->set_value(value);
+            return node;
+        }
+        pool.emplace_back(value);
+        pooled.insert(&pool.back());
+        return &pool.back();
+    }
+
+    void forget_cached(Node<T> *node)
+    {
+        std::vector<Node<T> *> stack = {node};
+        while (!stack.empty())
+        {
+            Node<T> *current = stack.back();
+            stack.pop_back();
+            aggregates.erase(current); // Nodes leaving the tree leave the caches too
+            hashes.erase(current);
+            published_nodes.erase(current); // Recycled addresses must not reuse a published copy
+            unpublished.erase(current);
+            for (auto child : current->get_children())
+            {
+                if (child)
+                    stack.push_back(child);
+            }
+        }
+    }
+
+    void require_binary() const
+    {
+        if (k != 2)
+            throw std::runtime_error("BST mode requires a binary tree."); // Left and right need exactly two slots
+    }
+
+    static Node<T> *child_at(const Node<T> *node, size_t slot)
+    {
+        const auto &children = node->get_children();
+        return slot < children.size() ? children[slot] : nullptr; // Missing and empty slots are both absent
+    }
+
+    T fold_children(Node<T> *node) const
+    {
+        T result = node->get_value();
         for (auto child : node->get_children())
         {
-            flatten_to_vector(child, result); // Recursively flatten children
+            if (child)
+                result = aggregate_op(result, aggregates.at(child)); // Combine cached child aggregates
+        }
+        return result;
+    }
+
+    T compute_aggregate(Node<T> *node) const
+    {
+        std::vector<std::pair<Node<T> *, size_t>> stack; // Node and index of next child to visit
+        stack.emplace_back(node, 0);
+        while (!stack.empty())
+        {
+            Node<T> *current = stack.back().first;
+            size_t &next = stack.back().second;
+            const auto &children = current->get_children();
+            if (next < children.size())
+            {
+                Node<T> *child = children[next++];
+                if (child)
+                    stack.emplace_back(child, 0);
+            }
+            else
+            {
+                aggregates.insert_or_assign(current, fold_children(current)); // All children are cached, fold this node
+                stack.pop_back();
+            }
         }
+        return aggregates.at(node);
     }
 
-    void delete_tree(Node<T> *node)
+    static void flatten_to_vector(Node<T> *node, std::vector<Node<T> *> &result)
     {
         if (!node)
             return;
+        result.push_back(node); // Add current node to result
         for (auto child : node->get_children())
         {
-            delete_tree(child); // Recursively delete children
+            flatten_to_vector(child, result); // Recursively flatten children
         }
-        delete node;    // Delete current node
-        node = nullptr; // Set node to null
     }
 
     Node<T> *find_node(Node<T> *current, const T &value) const
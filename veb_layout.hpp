@@ -0,0 +1,282 @@
+// Tsadik88@gmail.com
+#ifndef VEB_LAYOUT_HPP
+#define VEB_LAYOUT_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+#include "node.hpp"
+#include "tree.hpp"
+
+/**
+ * @class VebLayout
+ * @brief A read-only copy of a binary search tree stored contiguously in van Emde Boas order.
+ *
+ * A tree of height h is split into a top tree of about h/2 levels and the bottom trees
+ * hanging below it. The top tree is laid out first, then each bottom tree in turn, and
+ * the same split is applied recursively inside each part. Any root-to-leaf path then
+ * touches O(log_B n) blocks for every block size B at once, without tuning for a particular
+ * cache. Children are referenced by 32-bit indices, so a node costs the value plus 12 bytes.
+ *
+ * @tparam T The type of the values stored in the tree. It must define operator<.
+ */
+template <typename T>
+class VebLayout {
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1); ///< Returned when a value is not found.
+
+    /**
+     * @class const_iterator
+     * @brief A forward iterator over the values in in-order.
+     *
+     * It follows parent indices and allocates nothing.
+     */
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        const_iterator() : layout(nullptr), position(none) {}
+
+        const_iterator(const VebLayout* layout, uint32_t position) : layout(layout), position(position) {}
+
+        reference operator*() const { return layout->slots[position].value; }
+        pointer operator->() const { return &layout->slots[position].value; }
+
+        const_iterator& operator++() {
+            position = layout->successor(position);
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator previous = *this;
+            ++(*this);
+            return previous;
+        }
+
+        bool operator==(const const_iterator& other) const { return position == other.position; }
+        bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+        /**
+         * @brief Gets the layout index of the current node.
+         * @return The index, usable with VebLayout::value.
+         */
+        size_t index() const { return position; }
+
+    private:
+        const VebLayout* layout; ///< The layout being traversed.
+        uint32_t position;       ///< Index of the current node, none at the end.
+    };
+
+    /**
+     * @brief Copies a binary tree into van Emde Boas order.
+     * @param tree The tree to copy, ordered as a binary search tree with slot 0 as the left child.
+     * @throws std::runtime_error if a node has more than two children.
+     * @throws std::length_error if the tree has 2^32 - 1 nodes or more.
+     */
+    explicit VebLayout(const Tree<T>& tree) {
+        Node<T>* root = tree.get_root();
+        if (!root) {
+            return;
+        }
+        if (root->get_subtree_size() >= none) {
+            throw std::length_error("Tree too large for 32-bit layout indices");
+        }
+        order.reserve(root->get_subtree_size());
+        place(root, height_of(root));
+
+        std::unordered_map<const Node<T>*, uint32_t> index;
+        index.reserve(order.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            index[order[i]] = static_cast<uint32_t>(i);
+        }
+        slots.reserve(order.size());
+        for (Node<T>* node : order) {
+            auto lookup = [&](Node<T>* other) { return other ? index.at(other) : none; };
+            slots.push_back({node->get_value(), lookup(child(node, 0)), lookup(child(node, 1)),
+                             node == root ? none : lookup(node->get_parent())});
+        }
+        order.clear();
+        order.shrink_to_fit();
+    }
+
+    /**
+     * @brief Gets the number of nodes.
+     * @return The number of nodes.
+     */
+    size_t size() const { return slots.size(); }
+
+    /**
+     * @brief Gets the value at a layout index.
+     * @param index The layout index, where the root is 0.
+     * @return A constant reference to the value.
+     */
+    const T& value(size_t index) const { return slots[index].value; }
+
+    /**
+     * @brief Finds a node holding a value equivalent to the given one.
+     * @param value The value to search for.
+     * @return The layout index of the node, or npos if no node holds the value.
+     */
+    size_t find(const T& value) const {
+        uint32_t current = slots.empty() ? none : 0;
+        while (current != none) {
+            const slot& entry = slots[current];
+            if (value < entry.value) {
+                current = entry.left;
+            } else if (entry.value < value) {
+                current = entry.right;
+            } else {
+                return current;
+            }
+        }
+        return npos;
+    }
+
+    /**
+     * @brief Finds the first node in in-order whose value is not less than the given one.
+     * @param value The value to search for.
+     * @return An iterator to the node, or end() if every value is less.
+     */
+    const_iterator lower_bound(const T& value) const {
+        uint32_t result = none;
+        uint32_t current = slots.empty() ? none : 0;
+        while (current != none) {
+            const slot& entry = slots[current];
+            if (entry.value < value) {
+                current = entry.right;
+            } else {
+                result = current;
+                current = entry.left;
+            }
+        }
+        return const_iterator(this, result);
+    }
+
+    /**
+     * @brief Gets an iterator to the smallest value.
+     * @return The first in-order position.
+     */
+    const_iterator begin() const { return const_iterator(this, slots.empty() ? none : leftmost(0)); }
+
+    /**
+     * @brief Gets the past-the-end iterator.
+     * @return The end position.
+     */
+    const_iterator end() const { return const_iterator(this, none); }
+
+private:
+    static constexpr uint32_t none = UINT32_MAX; ///< Marks a missing child or parent.
+
+    /**
+     * @brief A node with the indices of its neighbours.
+     */
+    struct slot {
+        T value;         ///< The value stored in the node.
+        uint32_t left;   ///< Index of the left child.
+        uint32_t right;  ///< Index of the right child.
+        uint32_t parent; ///< Index of the parent, none for the root.
+    };
+
+    std::vector<slot> slots;       ///< Nodes in van Emde Boas order.
+    std::vector<Node<T>*> order;   ///< Source nodes in layout order, only used while building.
+
+    /**
+     * @brief Gets a child slot of a source node, or nullptr if the slot is empty or missing.
+     */
+    static Node<T>* child(Node<T>* node, size_t slot_index) {
+        const auto& children = node->get_children();
+        if (children.size() > 2) {
+            throw std::runtime_error("Van Emde Boas layout requires a binary tree.");
+        }
+        return slot_index < children.size() ? children[slot_index] : nullptr;
+    }
+
+    /**
+     * @brief Counts the levels below a source node.
+     */
+    static size_t height_of(Node<T>* root) {
+        size_t height = 0;
+        std::vector<std::pair<Node<T>*, size_t>> stack = {{root, 1}};
+        while (!stack.empty()) {
+            auto [node, depth] = stack.back();
+            stack.pop_back();
+            height = std::max(height, depth);
+            for (size_t i = 0; i < 2; ++i) {
+                if (Node<T>* next = child(node, i)) {
+                    stack.emplace_back(next, depth + 1);
+                }
+            }
+        }
+        return height;
+    }
+
+    /**
+     * @brief Appends the first levels of a subtree to the layout in van Emde Boas order.
+     * @param node The root of the subtree.
+     * @param height The number of levels to place.
+     */
+    void place(Node<T>* node, size_t height) {
+        if (height == 1) {
+            order.push_back(node);
+            return;
+        }
+        size_t top = height / 2;
+        place(node, top);
+
+        // Roots of the bottom trees, left to right
+        std::vector<Node<T>*> bottoms;
+        std::vector<std::pair<Node<T>*, size_t>> stack = {{node, 0}};
+        while (!stack.empty()) {
+            auto [current, depth] = stack.back();
+            stack.pop_back();
+            if (depth == top) {
+                bottoms.push_back(current);
+                continue;
+            }
+            for (size_t i = 2; i-- > 0;) {
+                if (Node<T>* next = child(current, i)) {
+                    stack.emplace_back(next, depth + 1);
+                }
+            }
+        }
+        for (Node<T>* bottom : bottoms) {
+            place(bottom, height - top);
+        }
+    }
+
+    /**
+     * @brief Follows left children down from a layout index.
+     */
+    uint32_t leftmost(uint32_t index) const {
+        while (slots[index].left != none) {
+            index = slots[index].left;
+        }
+        return index;
+    }
+
+    /**
+     * @brief Finds the next layout index in in-order, or none after the largest value.
+     */
+    uint32_t successor(uint32_t index) const {
+        if (slots[index].right != none) {
+            return leftmost(slots[index].right);
+        }
+        uint32_t parent = slots[index].parent;
+        while (parent != none && slots[parent].right == index) {
+            index = parent; // Climb out of right subtrees, which are already done
+            parent = slots[index].parent;
+        }
+        return parent;
+    }
+};
+
+#endif // VEB_LAYOUT_HPP